@@ -0,0 +1,124 @@
+#include "bench.hpp"
+
+#include <mz/piecewise/any_builder.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct InvalidError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  class Leaf final : public mp::Helpers<Leaf> {
+  private:
+    friend class mp::Helpers<Leaf>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int value
+      ) {
+        if (value < 0) return on_fail(InvalidError{});
+        return on_success(mp::builder(constructor, value));
+      };
+    }
+
+    int value;
+
+  public:
+    Leaf(typename mp::Helpers<Leaf>::Private, int value_) : value{value_} {}
+
+    int get() const { return value; }
+  };
+
+  using AnyLeaf = mp::AnyBuilder<Leaf, InvalidError>;
+
+  class Pair final : public mp::Helpers<Pair> {
+  private:
+    friend class mp::Helpers<Pair>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto left, auto right
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(left), std::move(right))
+        );
+      };
+    }
+
+    Leaf left;
+    Leaf right;
+
+  public:
+    template <typename L, typename R>
+    Pair(typename mp::Helpers<Pair>::Private, L left_, R right_)
+      : left{std::move(left_).construct()}
+      , right{std::move(right_).construct()}
+    {}
+
+    int sum() const { return left.get() + right.get(); }
+  };
+
+  template <typename Builder>
+  int run(Builder builder) {
+    return std::move(builder).construct(
+      [](auto post) { return std::move(post).construct().get(); }
+    , [](auto) { return -1; }
+    );
+  }
+
+  void leaf_templated(bench::State &state) {
+    int value = 1;
+    while (state.keep_running()) {
+      bench::do_not_optimize(value);
+      bench::do_not_optimize(run(Leaf::builder(value)));
+    }
+  }
+
+  // Includes erasing the builder, as code that picks one at runtime would
+  void leaf_erased(bench::State &state) {
+    int value = 1;
+    while (state.keep_running()) {
+      bench::do_not_optimize(value);
+      bench::do_not_optimize(run(AnyLeaf{Leaf::builder(value)}));
+    }
+  }
+
+  template <typename Wrap>
+  void pair(bench::State &state, Wrap wrap) {
+    int value = 1;
+    while (state.keep_running()) {
+      bench::do_not_optimize(value);
+      int result = Pair::builder(
+        wrap(Leaf::builder(value)), wrap(Leaf::builder(value + 1))
+      ).construct(
+        [](auto builder) { return std::move(builder).construct().sum(); }
+      , [](auto) { return -1; }
+      );
+      bench::do_not_optimize(result);
+    }
+  }
+
+  void pair_templated(bench::State &state) {
+    pair(state, [](auto builder) { return std::move(builder).own(); });
+  }
+
+  void pair_erased(bench::State &state) {
+    pair(state, [](auto builder) { return AnyLeaf{std::move(builder)}; });
+  }
+}
+
+BENCHMARK("any_builder/leaf/templated", leaf_templated);
+BENCHMARK("any_builder/leaf/erased", leaf_erased);
+BENCHMARK("any_builder/pair/templated", pair_templated);
+BENCHMARK("any_builder/pair/erased", pair_erased);
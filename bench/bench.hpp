@@ -0,0 +1,74 @@
+#ifndef UUID_0B7E2C44_3A9B_4E55_9B0D_6A2F5C1E8D43
+#define UUID_0B7E2C44_3A9B_4E55_9B0D_6A2F5C1E8D43
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A deliberately tiny benchmark harness so the benchmarks have no dependencies
+// beyond the standard library.
+namespace bench {
+  class State {
+  public:
+    explicit State(std::size_t iterations_) : iterations{iterations_} {}
+
+    bool keep_running() { return remaining-- > 0; }
+
+    // Attach an extra per-iteration number to the report, e.g. a move count
+    void counter(std::string name, double value) {
+      counters.emplace_back(std::move(name), value);
+    }
+
+    std::size_t get_iterations() const { return iterations; }
+    std::vector<std::pair<std::string, double>> const &get_counters() const {
+      return counters;
+    }
+
+  private:
+    std::size_t iterations;
+    std::size_t remaining = iterations;
+    std::vector<std::pair<std::string, double>> counters;
+  };
+
+  using Function = void (*)(State&);
+
+  struct Case {
+    std::string name;
+    Function function;
+  };
+
+  inline std::vector<Case> &registry() {
+    static std::vector<Case> cases;
+    return cases;
+  }
+
+  struct Register {
+    Register(std::string name, Function function) {
+      registry().push_back({std::move(name), function});
+    }
+  };
+
+  // Prevents the optimizer from discarding a computed value
+  template <typename T>
+  inline void do_not_optimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char const *sink;
+    sink = reinterpret_cast<char const volatile *>(&value);
+#endif
+  }
+
+  int run(int argc, char **argv);
+}
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+// Registers `function` under `name`. Call from namespace scope.
+#define BENCHMARK(name, function) \
+  static ::bench::Register BENCH_CONCAT(bench_register_, __LINE__){name, function}
+
+#endif
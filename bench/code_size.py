@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Code-size benchmark for wide and deep multifail graphs.
+
+Compiles the same synthetic aggregates as `compile_time.py`, with leaf values
+that are only known at runtime, at each requested optimization level and
+records, per object file:
+
+* the size of all `.text` sections in bytes
+* the number of emitted `mz::piecewise` function symbols
+* the total size of those symbols in bytes
+
+Results are compared against a tracked baseline so regressions can fail CI.
+
+Usage:
+  code_size.py [options] -- <compiler command...>
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from compile_time import (
+  PIECEWISE_MANGLED, compiler_identity, generate_source, parse_list
+)
+
+
+def text_bytes(obj):
+  output = subprocess.run(
+    ['size', '-A', obj], stdout=subprocess.PIPE, universal_newlines=True
+  ).stdout
+  total = 0
+  for line in output.splitlines():
+    fields = line.split()
+    if len(fields) >= 2 and fields[0].startswith('.text'):
+      total += int(fields[1])
+  return total
+
+
+def piecewise_symbols(obj):
+  output = subprocess.run(
+    ['nm', '-S', '--defined-only', obj]
+  , stdout=subprocess.PIPE, universal_newlines=True
+  ).stdout
+  count, total = 0, 0
+  for line in output.splitlines():
+    # address size type name
+    fields = line.split(None, 3)
+    if len(fields) < 4 or fields[2] not in 'TtWw':
+      continue
+    if PIECEWISE_MANGLED not in fields[3]:
+      continue
+    count += 1
+    total += int(fields[1], 16)
+  return count, total
+
+
+def measure(cxx, args, width, depth, level, workdir):
+  name = 'w%d_d%d_O%s' % (width, depth, level)
+  source = os.path.join(workdir, name + '.cpp')
+  obj = os.path.join(workdir, name + '.o')
+  with open(source, 'w') as f:
+    f.write(generate_source(width, depth, runtime_values=True))
+
+  command = cxx + [
+    '-std=' + args.std, '-O' + level, '-I', args.include
+  , '-c', source, '-o', obj
+  ]
+  if subprocess.run(command).returncode != 0:
+    raise RuntimeError('compilation failed: %s' % ' '.join(command))
+
+  symbols, symbol_bytes = piecewise_symbols(obj)
+  return {
+    'text_bytes': text_bytes(obj)
+  , 'symbols': symbols
+  , 'symbol_bytes': symbol_bytes
+  }
+
+
+METRICS = ('text_bytes', 'symbols', 'symbol_bytes')
+
+
+def compare(args, baseline, results):
+  regressions = []
+  for case, metrics in sorted(results.items()):
+    base = baseline.get(case)
+    if base is None:
+      continue
+    for metric in METRICS:
+      old, new = base.get(metric), metrics.get(metric)
+      if old is None or new is None or old == 0:
+        continue
+      if new > old * (1.0 + args.tolerance):
+        regressions.append(
+          '%s %s: %s -> %s (+%.0f%%)'
+          % (case, metric, old, new, 100.0 * (new - old) / old)
+        )
+  return regressions
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  parser.add_argument('--include', required=True, help='piecewise include dir')
+  parser.add_argument('--std', default='c++14')
+  parser.add_argument('--widths', type=parse_list, default=[1, 2, 4, 8, 16, 24])
+  parser.add_argument('--depths', type=parse_list, default=[1, 2])
+  parser.add_argument('--levels', default='0,2'
+  , help='comma separated optimization levels, e.g. 0,2,s')
+  parser.add_argument('--baseline', help='baseline JSON file to compare against')
+  parser.add_argument('--update-baseline', action='store_true'
+  , help='write the results into the baseline instead of comparing')
+  parser.add_argument('--output', help='write the raw results to this JSON file')
+  parser.add_argument('--tolerance', type=float, default=0.02)
+  parser.add_argument('cxx', nargs='+', help='compiler command')
+  args = parser.parse_args()
+
+  identity, _ = compiler_identity(args.cxx)
+  key = '%s/%s' % (identity, args.std)
+  levels = [l for l in args.levels.replace(',', ' ').split()]
+
+  results = {}
+  with tempfile.TemporaryDirectory() as workdir:
+    for level in levels:
+      for depth in args.depths:
+        for width in args.widths:
+          case = 'w%d_d%d_O%s' % (width, depth, level)
+          results[case] = measure(args.cxx, args, width, depth, level, workdir)
+          metrics = results[case]
+          print(
+            '%-24s %-12s %8d bytes .text %6d symbols %8d bytes in symbols'
+            % (
+              key, case, metrics['text_bytes'], metrics['symbols']
+            , metrics['symbol_bytes']
+            )
+          , flush=True
+          )
+
+  if args.output:
+    with open(args.output, 'w') as f:
+      json.dump({key: results}, f, indent=2, sort_keys=True)
+
+  if not args.baseline:
+    return 0
+
+  baselines = {}
+  if os.path.exists(args.baseline):
+    with open(args.baseline) as f:
+      baselines = json.load(f)
+
+  if args.update_baseline:
+    baselines[key] = results
+    with open(args.baseline, 'w') as f:
+      json.dump(baselines, f, indent=2, sort_keys=True)
+      f.write('\n')
+    print('Updated baseline for %s in %s' % (key, args.baseline))
+    return 0
+
+  if key not in baselines:
+    print('No baseline recorded for %s; run the update target first' % key)
+    return 0
+
+  regressions = compare(args, baselines[key], results)
+  for regression in regressions:
+    print('REGRESSION: ' + regression)
+  return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
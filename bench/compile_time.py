@@ -0,0 +1,339 @@
+#!/usr/bin/env python3
+"""Compile-time benchmark for wide and deep multifail graphs.
+
+Generates synthetic translation units containing `mp::Helpers` aggregates of a
+given width (builders per `mp::builders(...)`) and nesting depth, compiles
+each one, and records:
+
+* wall time of the compile (best of `--repeat` runs)
+* peak resident memory of the compiler
+* emitted `mz::piecewise` function symbols at -O0 (every compiler)
+* template instantiations reported by `-ftime-trace` (Clang only)
+
+Results are compared against a tracked baseline so regressions can fail CI.
+
+Usage:
+  compile_time.py [options] -- <compiler command...>
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+HEADER = """\
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct NegativeError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  template <int Level, int Index>
+  class Leaf final : public mp::Helpers<Leaf<Level, Index>> {
+  private:
+    friend class mp::Helpers<Leaf>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int value
+      ) {
+        if (value < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, value));
+      };
+    }
+
+    int value;
+
+  public:
+    Leaf(typename mp::Helpers<Leaf>::Private, int value_) : value{value_} {}
+
+    int sum() const { return value; }
+  };
+"""
+
+FOOTER = """\
+}
+
+int main(int argc, char **) {
+  (void)argc;
+  return %(builder)s.construct(
+    [](auto builder) {
+      auto node = std::move(builder).construct();
+      return node.sum() == %(expected)d ? 0 : 1;
+    }
+  , [](auto) { return 2; }
+  );
+}
+"""
+
+
+def member_type(level, index):
+  if level > 1 and index == 0:
+    return 'Node%d' % (level - 1)
+  return 'Leaf<%d, %d>' % (level, index)
+
+
+def generate_node(level, width):
+  names = ['m%d' % i for i in range(width)]
+  builders = ['b%d' % i for i in range(width)]
+  types = ['B%d' % i for i in range(width)]
+  lines = []
+  lines.append('  class Node%d final : public mp::Helpers<Node%d> {' % (level, level))
+  lines.append('  private:')
+  lines.append('    friend class mp::Helpers<Node%d>;' % level)
+  lines.append('')
+  lines.append('    static auto factory() {')
+  lines.append('      return [](')
+  lines.append('        auto constructor')
+  lines.append('      , auto&& on_success, auto&& on_fail')
+  for b in builders:
+    lines.append('      , auto %s' % b)
+  lines.append('      ) {')
+  lines.append('        return mp::multifail(')
+  lines.append('          constructor')
+  lines.append('        , on_success, on_fail')
+  lines.append('        , mp::builders(')
+  lines.append('            ' + ', '.join('std::move(%s)' % b for b in builders))
+  lines.append('          )')
+  lines.append('        );')
+  lines.append('      };')
+  lines.append('    }')
+  lines.append('')
+  for i, name in enumerate(names):
+    lines.append('    %s %s;' % (member_type(level, i), name))
+  lines.append('')
+  lines.append('  public:')
+  lines.append('    template <%s>' % ', '.join('typename ' + t for t in types))
+  lines.append('    Node%d(' % level)
+  lines.append('      Private')
+  for t, b in zip(types, builders):
+    lines.append('    , %s %s' % (t, b))
+  lines.append('    ) : %s' % ', '.join(
+    '%s{std::move(%s).construct()}' % (n, b) for n, b in zip(names, builders)))
+  lines.append('    {}')
+  lines.append('')
+  lines.append('    int sum() const { return %s; }' % ' + '.join(
+    '%s.sum()' % n for n in names))
+  lines.append('  };')
+  lines.append('')
+  return '\n'.join(lines)
+
+
+# With `runtime_values`, leaf values depend on `argc`, so the optimizer can't
+# fold the whole graph into a constant
+def generate_builder(level, width, runtime_values=False):
+  value = 'argc - 1 + %d' if runtime_values else '%d'
+  args = []
+  total = 0
+  for i in range(width):
+    if level > 1 and i == 0:
+      nested, nested_total = generate_builder(level - 1, width, runtime_values)
+      args.append(nested)
+      total += nested_total
+    else:
+      args.append(
+        '%s::builder(%s)' % (member_type(level, i), value % i)
+      )
+      total += i
+  return 'Node%d::builder(%s)' % (level, ', '.join(args)), total
+
+
+def generate_source(width, depth, runtime_values=False):
+  parts = [HEADER]
+  for level in range(1, depth + 1):
+    parts.append(generate_node(level, width))
+  builder, expected = generate_builder(depth, width, runtime_values)
+  parts.append(FOOTER % {'builder': builder, 'expected': expected})
+  return '\n'.join(parts)
+
+
+def compiler_identity(cxx):
+  banner = subprocess.run(
+    cxx + ['--version'], stdout=subprocess.PIPE, universal_newlines=True
+  ).stdout
+  version = subprocess.run(
+    cxx + ['-dumpversion'], stdout=subprocess.PIPE, universal_newlines=True
+  ).stdout.strip()
+  family = 'clang' if 'clang' in banner.lower() else 'gcc'
+  return '%s-%s' % (family, version.split('.')[0]), family
+
+
+def run_compiler(command):
+  start = time.perf_counter()
+  process = subprocess.Popen(command)
+  _, status, usage = os.wait4(process.pid, 0)
+  elapsed = time.perf_counter() - start
+  process.returncode = os.waitstatus_to_exitcode(status)
+  if process.returncode != 0:
+    raise RuntimeError('compilation failed: %s' % ' '.join(command))
+  # ru_maxrss is reported in kilobytes on Linux and bytes on macOS
+  scale = 1 if sys.platform == 'darwin' else 1024
+  return elapsed, usage.ru_maxrss * scale
+
+
+# Matches mangled names, since nm can't demangle some of the names that lambdas
+# in templates produce
+PIECEWISE_MANGLED = '2mz9piecewise'
+
+
+def count_symbols(obj):
+  output = subprocess.run(
+    ['nm', '--defined-only', obj]
+  , stdout=subprocess.PIPE, universal_newlines=True
+  ).stdout
+  return sum(1 for line in output.splitlines() if PIECEWISE_MANGLED in line)
+
+
+def count_instantiations(trace):
+  with open(trace) as f:
+    events = json.load(f)['traceEvents']
+  return sum(
+    1 for e in events if e.get('name') in ('InstantiateFunction', 'InstantiateClass')
+  )
+
+
+def measure(cxx, family, args, width, depth, workdir):
+  source = os.path.join(workdir, 'w%d_d%d.cpp' % (width, depth))
+  obj = os.path.join(workdir, 'w%d_d%d.o' % (width, depth))
+  with open(source, 'w') as f:
+    f.write(generate_source(width, depth))
+
+  command = cxx + [
+    '-std=' + args.std, '-O0', '-I', args.include, '-c', source, '-o', obj
+  ]
+  if family == 'clang':
+    command += ['-ftime-trace', '-ftime-trace-granularity=0']
+
+  # Keep the best of each metric so scheduling noise doesn't look like a
+  # regression
+  best_time, peak_rss = None, None
+  for _ in range(args.repeat):
+    elapsed, rss = run_compiler(command)
+    best_time = elapsed if best_time is None else min(best_time, elapsed)
+    peak_rss = rss if peak_rss is None else min(peak_rss, rss)
+
+  result = {
+    'wall_s': round(best_time, 3)
+  , 'peak_rss_mb': round(peak_rss / (1024.0 * 1024.0), 1)
+  , 'symbols': count_symbols(obj)
+  , 'instantiations': None
+  }
+  if family == 'clang':
+    trace = os.path.splitext(obj)[0] + '.json'
+    if os.path.exists(trace):
+      result['instantiations'] = count_instantiations(trace)
+  return result
+
+
+TOLERANCES = {
+  'wall_s': 'time_tolerance'
+, 'peak_rss_mb': 'memory_tolerance'
+, 'symbols': 'count_tolerance'
+, 'instantiations': 'count_tolerance'
+}
+
+
+def compare(args, baseline, results):
+  regressions = []
+  for case, metrics in sorted(results.items()):
+    base = baseline.get(case)
+    if base is None:
+      continue
+    for metric, tolerance in TOLERANCES.items():
+      old, new = base.get(metric), metrics.get(metric)
+      if old is None or new is None or old == 0:
+        continue
+      if new > old * (1.0 + getattr(args, tolerance)):
+        regressions.append(
+          '%s %s: %s -> %s (+%.0f%%)'
+          % (case, metric, old, new, 100.0 * (new - old) / old)
+        )
+  return regressions
+
+
+def parse_list(value):
+  return [int(v) for v in value.replace(',', ' ').split()]
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  parser.add_argument('--include', required=True, help='piecewise include dir')
+  parser.add_argument('--std', default='c++14')
+  parser.add_argument('--widths', type=parse_list, default=[1, 2, 4, 8, 16, 24])
+  parser.add_argument('--depths', type=parse_list, default=[1, 2])
+  parser.add_argument('--repeat', type=int, default=1)
+  parser.add_argument('--baseline', help='baseline JSON file to compare against')
+  parser.add_argument('--update-baseline', action='store_true'
+  , help='write the results into the baseline instead of comparing')
+  parser.add_argument('--output', help='write the raw results to this JSON file')
+  parser.add_argument('--time-tolerance', type=float, default=0.5)
+  parser.add_argument('--memory-tolerance', type=float, default=0.25)
+  parser.add_argument('--count-tolerance', type=float, default=0.05)
+  parser.add_argument('cxx', nargs='+', help='compiler command')
+  args = parser.parse_args()
+
+  identity, family = compiler_identity(args.cxx)
+  key = '%s/%s' % (identity, args.std)
+
+  results = {}
+  with tempfile.TemporaryDirectory() as workdir:
+    for depth in args.depths:
+      for width in args.widths:
+        case = 'w%d_d%d' % (width, depth)
+        results[case] = measure(args.cxx, family, args, width, depth, workdir)
+        metrics = results[case]
+        print(
+          '%-24s %-8s %8.3fs %8.1fMB %6d symbols %s'
+          % (
+            key, case, metrics['wall_s'], metrics['peak_rss_mb']
+          , metrics['symbols']
+          , '' if metrics['instantiations'] is None
+            else '%d instantiations' % metrics['instantiations']
+          )
+        , flush=True
+        )
+
+  if args.output:
+    with open(args.output, 'w') as f:
+      json.dump({key: results}, f, indent=2, sort_keys=True)
+
+  if not args.baseline:
+    return 0
+
+  baselines = {}
+  if os.path.exists(args.baseline):
+    with open(args.baseline) as f:
+      baselines = json.load(f)
+
+  if args.update_baseline:
+    baselines[key] = results
+    with open(args.baseline, 'w') as f:
+      json.dump(baselines, f, indent=2, sort_keys=True)
+      f.write('\n')
+    print('Updated baseline for %s in %s' % (key, args.baseline))
+    return 0
+
+  if key not in baselines:
+    print('No baseline recorded for %s; run the update target first' % key)
+    return 0
+
+  regressions = compare(args, baselines[key], results)
+  for regression in regressions:
+    print('REGRESSION: ' + regression)
+  return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,528 @@
+#include "bench.hpp"
+
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#if __cplusplus >= 201703L
+  #include <optional>
+  #include <variant>
+#endif
+
+// Every case has a hand-written counterpart that validates its arguments and
+// then calls a plain constructor, returning -1 on failure. The two are
+// registered next to each other, so the report reads as pairs. Arguments come
+// from `inputs`, which the optimizer can't see through, so neither side is
+// folded away.
+namespace mp = mz::piecewise;
+
+namespace {
+  std::array<int, 16> inputs;
+
+  struct InvalidError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  class Leaf final : public mp::Helpers<Leaf> {
+  private:
+    friend class mp::Helpers<Leaf>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int value
+      ) {
+        if (value < 0) return on_fail(InvalidError{});
+        return on_success(mp::builder(constructor, value));
+      };
+    }
+
+    int value;
+
+  public:
+    Leaf(typename mp::Helpers<Leaf>::Private, int value_) : value{value_} {}
+
+    int get() const { return value; }
+  };
+
+  class HandLeaf {
+  public:
+    static bool valid(int value) { return value >= 0; }
+
+    explicit HandLeaf(int value_) : value{value_} {}
+
+    int get() const { return value; }
+
+  private:
+    int value;
+  };
+
+  template <typename Builder>
+  int run(Builder builder) {
+    return std::move(builder).construct(
+      [](auto post) { return std::move(post).construct().get(); }
+    , [](auto) { return -1; }
+    );
+  }
+
+  // The argument is negative on the failure path
+  int input(bool fail) {
+    int value = inputs[0];
+    bench::do_not_optimize(value);
+    return fail ? -value - 1 : value;
+  }
+
+  template <bool Fail>
+  void single_piecewise(bench::State &state) {
+    while (state.keep_running()) {
+      bench::do_not_optimize(run(Leaf::builder(input(Fail))));
+    }
+  }
+
+  template <bool Fail>
+  void single_handwritten(bench::State &state) {
+    while (state.keep_running()) {
+      int value = input(Fail);
+      int result = HandLeaf::valid(value) ? HandLeaf{value}.get() : -1;
+      bench::do_not_optimize(result);
+    }
+  }
+
+  struct Point {
+    int x;
+    int y;
+  };
+
+  void wrapper_piecewise(bench::State &state) {
+    while (state.keep_running()) {
+      int result = mp::wrapper<Point>(input(false), input(false)).construct(
+        [](auto post) {
+          auto point = std::move(post).construct();
+          return point.x + point.y;
+        }
+      , [](auto) { return -1; }
+      );
+      bench::do_not_optimize(result);
+    }
+  }
+
+  void wrapper_handwritten(bench::State &state) {
+    while (state.keep_running()) {
+      Point point{input(false), input(false)};
+      bench::do_not_optimize(point.x + point.y);
+    }
+  }
+
+  // Aggregates of growing width, all members validated before any is built
+  template <typename ...Members>
+  class Wide final : public mp::Helpers<Wide<Members...>> {
+  private:
+    friend class mp::Helpers<Wide>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto... member_builders
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(member_builders)...)
+        );
+      };
+    }
+
+    std::tuple<Members...> members;
+
+    template <std::size_t ...Indices>
+    int sum(std::index_sequence<Indices...>) const {
+      int total = 0;
+      int expand[] = {0, (total += std::get<Indices>(members).get())...};
+      (void)expand;
+      return total;
+    }
+
+  public:
+    template <typename ...Builders>
+    Wide(typename mp::Helpers<Wide>::Private, Builders... member_builders)
+      : members{std::move(member_builders).construct()...}
+    {}
+
+    int get() const { return sum(std::index_sequence_for<Members...>{}); }
+  };
+
+  template <std::size_t Width>
+  class HandWide {
+  public:
+    static bool valid(std::array<int, Width> const &values) {
+      for (int value : values) if (!HandLeaf::valid(value)) return false;
+      return true;
+    }
+
+    explicit HandWide(std::array<int, Width> const &values)
+      : HandWide{values, std::make_index_sequence<Width>{}}
+    {}
+
+    int get() const {
+      int total = 0;
+      for (auto const &member : members) total += member.get();
+      return total;
+    }
+
+  private:
+    template <std::size_t ...Indices>
+    HandWide(
+      std::array<int, Width> const &values, std::index_sequence<Indices...>
+    ) : members{{HandLeaf{values[Indices]}...}}
+    {}
+
+    std::array<HandLeaf, Width> members;
+  };
+
+  template <std::size_t Index>
+  using LeafAt = Leaf;
+
+  // The last member fails on the failure path, so every factory still runs
+  template <std::size_t Width, bool Fail>
+  std::array<int, Width> wide_inputs() {
+    std::array<int, Width> values;
+    for (std::size_t i = 0; i < Width; ++i) values[i] = input(false);
+    if (Fail) values[Width - 1] = input(true);
+    return values;
+  }
+
+  template <bool Fail, std::size_t ...Indices>
+  void wide_piecewise(bench::State &state, std::index_sequence<Indices...>) {
+    while (state.keep_running()) {
+      auto values = wide_inputs<sizeof...(Indices), Fail>();
+      bench::do_not_optimize(
+        run(
+          Wide<LeafAt<Indices>...>::builder(Leaf::builder(values[Indices])...)
+        )
+      );
+    }
+  }
+
+  template <std::size_t Width, bool Fail>
+  void wide_piecewise(bench::State &state) {
+    wide_piecewise<Fail>(state, std::make_index_sequence<Width>{});
+  }
+
+  template <std::size_t Width, bool Fail>
+  void wide_handwritten(bench::State &state) {
+    while (state.keep_running()) {
+      auto values = wide_inputs<Width, Fail>();
+      int result = HandWide<Width>::valid(values)
+        ? HandWide<Width>{values}.get()
+        : -1;
+      bench::do_not_optimize(result);
+    }
+  }
+
+  // Binary trees of aggregates, `2^Depth` leaves each
+  template <std::size_t Depth>
+  class Tree final : public mp::Helpers<Tree<Depth>> {
+  private:
+    friend class mp::Helpers<Tree>;
+    using Child = std::conditional_t<Depth == 1, Leaf, Tree<Depth - 1>>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto left, auto right
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(left), std::move(right))
+        );
+      };
+    }
+
+    Child left;
+    Child right;
+
+  public:
+    template <typename L, typename R>
+    Tree(typename mp::Helpers<Tree>::Private, L left_, R right_)
+      : left{std::move(left_).construct()}
+      , right{std::move(right_).construct()}
+    {}
+
+    int get() const { return left.get() + right.get(); }
+  };
+
+  // Builders refer to their arguments, so a tree of them is made in
+  // continuation passing style, with every builder alive in a caller's frame
+  template <std::size_t Depth>
+  struct TreeBuilder {
+    template <typename Continuation>
+    static int with(int const *values, Continuation &&continuation) {
+      return TreeBuilder<Depth - 1>::with(values, [&](auto&& left) {
+        return TreeBuilder<Depth - 1>::with(
+          values + (std::size_t{1} << (Depth - 1))
+        , [&](auto&& right) {
+            return continuation(
+              Tree<Depth>::builder(std::move(left), std::move(right))
+            );
+          }
+        );
+      });
+    }
+  };
+
+  template <>
+  struct TreeBuilder<0> {
+    template <typename Continuation>
+    static int with(int const *values, Continuation &&continuation) {
+      return continuation(Leaf::builder(*values));
+    }
+  };
+
+  template <std::size_t Depth>
+  class HandTree {
+  public:
+    static bool valid(int const *values) {
+      for (std::size_t i = 0; i < (std::size_t{1} << Depth); ++i) {
+        if (!HandLeaf::valid(values[i])) return false;
+      }
+      return true;
+    }
+
+    explicit HandTree(int const *values)
+      : left{values}
+      , right{values + (std::size_t{1} << (Depth - 1))}
+    {}
+
+    int get() const { return left.get() + right.get(); }
+
+  private:
+    HandTree<Depth - 1> left;
+    HandTree<Depth - 1> right;
+  };
+
+  template <>
+  class HandTree<0> {
+  public:
+    explicit HandTree(int const *values) : leaf{*values} {}
+
+    int get() const { return leaf.get(); }
+
+  private:
+    HandLeaf leaf;
+  };
+
+  template <std::size_t Depth, bool Fail>
+  void deep_piecewise(bench::State &state) {
+    while (state.keep_running()) {
+      auto values = wide_inputs<std::size_t{1} << Depth, Fail>();
+      bench::do_not_optimize(
+        TreeBuilder<Depth>::with(values.data(), [](auto builder) {
+          return run(std::move(builder));
+        })
+      );
+    }
+  }
+
+  template <std::size_t Depth, bool Fail>
+  void deep_handwritten(bench::State &state) {
+    while (state.keep_running()) {
+      auto values = wide_inputs<std::size_t{1} << Depth, Fail>();
+      int result = HandTree<Depth>::valid(values.data())
+        ? HandTree<Depth>{values.data()}.get()
+        : -1;
+      bench::do_not_optimize(result);
+    }
+  }
+
+  // Succeeds for half of the arguments and fails with one of four errors for
+  // the rest
+  struct RedError {};
+  struct GreenError {};
+  struct BlueError {};
+  struct AlphaError {};
+
+  enum class HandError { none, red, green, blue, alpha };
+
+  class Color final : public mp::Helpers<Color> {
+  private:
+    friend class mp::Helpers<Color>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int value
+      ) {
+        switch (value & 7) {
+          case 4: return on_fail(RedError{});
+          case 5: return on_fail(GreenError{});
+          case 6: return on_fail(BlueError{});
+          case 7: return on_fail(AlphaError{});
+          default: return on_success(mp::builder(constructor, value));
+        }
+      };
+    }
+
+    int value;
+
+  public:
+    Color(typename mp::Helpers<Color>::Private, int value_)
+      : value{value_}
+    {}
+
+    int get() const { return value; }
+  };
+
+  HandError hand_validate(int value) {
+    switch (value & 7) {
+      case 4: return HandError::red;
+      case 5: return HandError::green;
+      case 6: return HandError::blue;
+      case 7: return HandError::alpha;
+      default: return HandError::none;
+    }
+  }
+
+  // Cycles through every outcome
+  int color_input(std::size_t iteration) {
+    return input(false) * 8 + static_cast<int>(iteration & 7);
+  }
+
+  void dispatch_piecewise(bench::State &state) {
+    std::size_t iteration = 0;
+    while (state.keep_running()) {
+      int result = Color::builder(color_input(iteration++)).construct(
+        [](auto post) { return std::move(post).construct().get(); }
+      , mp::handler(
+          [](RedError) { return -1; }
+        , [](GreenError) { return -2; }
+        , [](BlueError) { return -3; }
+        , [](AlphaError) { return -4; }
+        )
+      );
+      bench::do_not_optimize(result);
+    }
+  }
+
+  void dispatch_handwritten(bench::State &state) {
+    std::size_t iteration = 0;
+    while (state.keep_running()) {
+      int value = color_input(iteration++);
+      int result = 0;
+      switch (hand_validate(value)) {
+        case HandError::none: result = HandLeaf{value}.get(); break;
+        case HandError::red: result = -1; break;
+        case HandError::green: result = -2; break;
+        case HandError::blue: result = -3; break;
+        case HandError::alpha: result = -4; break;
+      }
+      bench::do_not_optimize(result);
+    }
+  }
+
+#if __cplusplus >= 201703L
+  template <bool Fail>
+  void optional_piecewise(bench::State &state) {
+    while (state.keep_running()) {
+      auto leaf = Leaf::optional(input(Fail)).construct([](auto) {});
+      bench::do_not_optimize(leaf ? leaf->get() : -1);
+    }
+  }
+
+  template <bool Fail>
+  void optional_handwritten(bench::State &state) {
+    while (state.keep_running()) {
+      int value = input(Fail);
+      auto leaf = HandLeaf::valid(value)
+        ? std::optional<HandLeaf>{std::in_place, value}
+        : std::nullopt;
+      bench::do_not_optimize(leaf ? leaf->get() : -1);
+    }
+  }
+
+  template <bool Fail>
+  void variant_piecewise(bench::State &state) {
+    while (state.keep_running()) {
+      auto leaf = Leaf::variant<InvalidError>(input(Fail));
+      auto *success = std::get_if<Leaf>(&leaf);
+      bench::do_not_optimize(success ? success->get() : -1);
+    }
+  }
+
+  template <bool Fail>
+  void variant_handwritten(bench::State &state) {
+    using Variant = std::variant<HandLeaf, InvalidError>;
+    while (state.keep_running()) {
+      int value = input(Fail);
+      auto leaf = HandLeaf::valid(value)
+        ? Variant{std::in_place_index<0>, value}
+        : Variant{InvalidError{}};
+      auto *success = std::get_if<HandLeaf>(&leaf);
+      bench::do_not_optimize(success ? success->get() : -1);
+    }
+  }
+#endif
+
+  struct Inputs {
+    Inputs() { inputs.fill(1); }
+  } const initialize_inputs;
+}
+
+BENCHMARK("construction/single/success/piecewise", single_piecewise<false>);
+BENCHMARK("construction/single/success/handwritten", single_handwritten<false>);
+BENCHMARK("construction/single/fail/piecewise", single_piecewise<true>);
+BENCHMARK("construction/single/fail/handwritten", single_handwritten<true>);
+BENCHMARK("construction/wrapper/piecewise", wrapper_piecewise);
+BENCHMARK("construction/wrapper/handwritten", wrapper_handwritten);
+BENCHMARK("construction/width=4/success/piecewise", (wide_piecewise<4, false>));
+BENCHMARK(
+  "construction/width=4/success/handwritten", (wide_handwritten<4, false>)
+);
+BENCHMARK("construction/width=4/fail/piecewise", (wide_piecewise<4, true>));
+BENCHMARK("construction/width=4/fail/handwritten", (wide_handwritten<4, true>));
+BENCHMARK(
+  "construction/width=16/success/piecewise", (wide_piecewise<16, false>)
+);
+BENCHMARK(
+  "construction/width=16/success/handwritten", (wide_handwritten<16, false>)
+);
+BENCHMARK("construction/width=16/fail/piecewise", (wide_piecewise<16, true>));
+BENCHMARK(
+  "construction/width=16/fail/handwritten", (wide_handwritten<16, true>)
+);
+BENCHMARK("construction/depth=2/success/piecewise", (deep_piecewise<2, false>));
+BENCHMARK(
+  "construction/depth=2/success/handwritten", (deep_handwritten<2, false>)
+);
+BENCHMARK("construction/depth=4/success/piecewise", (deep_piecewise<4, false>));
+BENCHMARK(
+  "construction/depth=4/success/handwritten", (deep_handwritten<4, false>)
+);
+BENCHMARK("construction/depth=4/fail/piecewise", (deep_piecewise<4, true>));
+BENCHMARK("construction/depth=4/fail/handwritten", (deep_handwritten<4, true>));
+BENCHMARK("construction/dispatch/piecewise", dispatch_piecewise);
+BENCHMARK("construction/dispatch/handwritten", dispatch_handwritten);
+#if __cplusplus >= 201703L
+BENCHMARK("construction/optional/success/piecewise", optional_piecewise<false>);
+BENCHMARK(
+  "construction/optional/success/handwritten", optional_handwritten<false>
+);
+BENCHMARK("construction/optional/fail/piecewise", optional_piecewise<true>);
+BENCHMARK("construction/optional/fail/handwritten", optional_handwritten<true>);
+BENCHMARK("construction/variant/success/piecewise", variant_piecewise<false>);
+BENCHMARK(
+  "construction/variant/success/handwritten", variant_handwritten<false>
+);
+BENCHMARK("construction/variant/fail/piecewise", variant_piecewise<true>);
+BENCHMARK("construction/variant/fail/handwritten", variant_handwritten<true>);
+#endif
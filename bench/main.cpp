@@ -0,0 +1,56 @@
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace bench {
+  namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double seconds(Clock::duration duration) {
+      return std::chrono::duration<double>(duration).count();
+    }
+  }
+
+  // Usage: bench [substring filter] [minimum seconds per case]
+  int run(int argc, char **argv) {
+    char const *filter = argc > 1 ? argv[1] : "";
+    double min_time = argc > 2 ? std::atof(argv[2]) : 0.2;
+
+    std::printf("%-56s %14s %12s\n", "benchmark", "iterations", "ns/iter");
+    for (auto const &c : registry()) {
+      if (std::strstr(c.name.c_str(), filter) == nullptr) continue;
+
+      // Double the iteration count until a run is long enough to trust
+      std::size_t iterations = 1;
+      double elapsed = 0;
+      State state{iterations};
+      for (;;) {
+        state = State{iterations};
+        auto start = Clock::now();
+        c.function(state);
+        elapsed = seconds(Clock::now() - start);
+        if (elapsed >= min_time || iterations >= (std::size_t{1} << 30)) break;
+        iterations *= 2;
+      }
+
+      std::printf(
+        "%-56s %14zu %12.2f"
+      , c.name.c_str()
+      , iterations
+      , elapsed * 1e9 / static_cast<double>(iterations)
+      );
+      for (auto const &counter : state.get_counters()) {
+        std::printf("  %s=%g", counter.first.c_str(), counter.second);
+      }
+      std::printf("\n");
+    }
+    return 0;
+  }
+}
+
+int main(int argc, char **argv) {
+  return bench::run(argc, argv);
+}
@@ -0,0 +1,164 @@
+#include "bench.hpp"
+#include "legacy_multifail.hpp"
+
+#include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <tuple>
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  std::size_t builder_moves = 0;
+
+  // Every post-factory builder stores its construction callback by value, so
+  // wrapping the callback counts how often multifail moves those builders.
+  template <typename Constructor>
+  struct CountingConstructor {
+    Constructor constructor;
+
+    explicit CountingConstructor(Constructor constructor_)
+      : constructor{std::move(constructor_)}
+    {}
+    CountingConstructor(CountingConstructor const &) = default;
+    CountingConstructor(CountingConstructor &&other)
+      : constructor{std::move(other.constructor)}
+    { ++builder_moves; }
+
+    template <typename ...Args>
+    auto operator()(Args&&... args) const {
+      return constructor(std::forward<Args>(args)...);
+    }
+  };
+
+  template <typename Constructor>
+  CountingConstructor<Constructor> counting(Constructor constructor) {
+    return CountingConstructor<Constructor>{std::move(constructor)};
+  }
+
+  struct InvalidError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  template <std::size_t Index>
+  class Leaf final : public mp::Helpers<Leaf<Index>> {
+  private:
+    friend class mp::Helpers<Leaf>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int value
+      ) {
+        if (value < 0) return on_fail(InvalidError{});
+        return on_success(mp::builder(counting(constructor), value));
+      };
+    }
+
+    int value;
+
+  public:
+    Leaf(typename mp::Helpers<Leaf>::Private, int value_) : value{value_} {}
+
+    int get() const { return value; }
+  };
+
+  struct Flat {
+    template <typename ...Args>
+    static auto multifail(Args&&... args) {
+      return mp::multifail(std::forward<Args>(args)...);
+    }
+  };
+
+  struct Recursive {
+    template <typename ...Args>
+    static auto multifail(Args&&... args) {
+      return legacy::multifail(std::forward<Args>(args)...);
+    }
+  };
+
+  template <typename Engine, typename ...Members>
+  class Wide final : public mp::Helpers<Wide<Engine, Members...>> {
+  private:
+    friend class mp::Helpers<Wide>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto... member_builders
+      ) {
+        return Engine::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(member_builders)...)
+        );
+      };
+    }
+
+    std::tuple<Members...> members;
+
+    template <std::size_t ...Indices>
+    int sum(std::index_sequence<Indices...>) const {
+      int total = 0;
+      int expand[] = {0, (total += std::get<Indices>(members).get())...};
+      (void)expand;
+      return total;
+    }
+
+  public:
+    template <typename ...Builders>
+    Wide(typename mp::Helpers<Wide>::Private, Builders... member_builders)
+      : members{std::move(member_builders).construct()...}
+    {}
+
+    int sum() const { return sum(std::index_sequence_for<Members...>{}); }
+  };
+
+  template <typename Engine, int FailAt, std::size_t ...Indices>
+  void run_wide(bench::State &state, std::index_sequence<Indices...>) {
+    using Aggregate = Wide<Engine, Leaf<Indices>...>;
+    std::size_t moves = 0;
+    while (state.keep_running()) {
+      builder_moves = 0;
+      int result = Aggregate::builder(
+        Leaf<Indices>::builder(
+          static_cast<int>(Indices) == FailAt ? -1 : static_cast<int>(Indices)
+        )...
+      ).construct(
+        [](auto builder) { return std::move(builder).construct().sum(); }
+      , [](auto) { return -1; }
+      );
+      bench::do_not_optimize(result);
+      moves = builder_moves;
+    }
+    state.counter("builder_moves", static_cast<double>(moves));
+  }
+
+  template <typename Engine, std::size_t Width>
+  void succeed(bench::State &state) {
+    run_wide<Engine, -1>(state, std::make_index_sequence<Width>{});
+  }
+
+  // The last member fails, so every factory still runs
+  template <typename Engine, std::size_t Width>
+  void fail_last(bench::State &state) {
+    run_wide<Engine, static_cast<int>(Width) - 1>(
+      state, std::make_index_sequence<Width>{}
+    );
+  }
+}
+
+BENCHMARK("multifail/flat/success/width=1", (succeed<Flat, 1>));
+BENCHMARK("multifail/flat/success/width=4", (succeed<Flat, 4>));
+BENCHMARK("multifail/flat/success/width=8", (succeed<Flat, 8>));
+BENCHMARK("multifail/flat/success/width=16", (succeed<Flat, 16>));
+BENCHMARK("multifail/flat/fail_last/width=16", (fail_last<Flat, 16>));
+BENCHMARK("multifail/recursive/success/width=1", (succeed<Recursive, 1>));
+BENCHMARK("multifail/recursive/success/width=4", (succeed<Recursive, 4>));
+BENCHMARK("multifail/recursive/success/width=8", (succeed<Recursive, 8>));
+BENCHMARK("multifail/recursive/success/width=16", (succeed<Recursive, 16>));
+BENCHMARK("multifail/recursive/fail_last/width=16", (fail_last<Recursive, 16>));
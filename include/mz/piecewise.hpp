@@ -1,7 +1,22 @@
+#include <mz/piecewise/allocator.hpp>
+#include <mz/piecewise/any_builder.hpp>
+#include <mz/piecewise/arena.hpp>
+#include <mz/piecewise/batch.hpp>
 #include <mz/piecewise/builder.hpp>
 #include <mz/piecewise/construct_helpers.hpp>
+#include <mz/piecewise/deadline.hpp>
 #include <mz/piecewise/factory.hpp>
 #include <mz/piecewise/forward_tuple.hpp>
+#include <mz/piecewise/heap.hpp>
+#include <mz/piecewise/in_place.hpp>
 #include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/chrome_tracer.hpp>
+#include <mz/piecewise/lazy.hpp>
 #include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/multifail_async.hpp>
+#include <mz/piecewise/parallel_multifail.hpp>
+#include <mz/piecewise/reload.hpp>
+#include <mz/piecewise/result.hpp>
+#include <mz/piecewise/shared.hpp>
+#include <mz/piecewise/trace.hpp>
 #include <mz/piecewise/tuple_list.hpp>
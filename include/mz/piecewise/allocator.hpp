@@ -0,0 +1,245 @@
+#ifndef UUID_B24787C2_6B79_4495_991D_563F28E61FB9
+#define UUID_B24787C2_6B79_4495_991D_563F28E61FB9
+
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 201703L
+  #include <mz/piecewise/builder.hpp>
+  #include <mz/piecewise/factory.hpp>
+  #include <mz/piecewise/helpers.hpp>
+
+  #include <cstddef>
+  #include <initializer_list>
+  #include <memory>
+  #include <memory_resource>
+#endif
+
+// Since C++17, a memory resource given to `with_resource` is used by every
+// allocator-aware type that a pre-factory builder's `construct` constructs on
+// the calling thread. Like a deadline (see deadline.hpp), that covers the
+// nested factories and constructors of the whole aggregate, as long as the
+// post-factory builders are constructed from inside the callbacks.
+namespace mz { namespace piecewise {
+#if __cplusplus >= 201703L
+  using Allocator = std::pmr::polymorphic_allocator<std::byte>;
+
+  namespace detail {
+    // The resource of the innermost scope on this thread, if any
+    inline std::pmr::memory_resource *&scoped_resource() noexcept {
+      static thread_local std::pmr::memory_resource *resource = nullptr;
+      return resource;
+    }
+  }
+
+  // Makes `resource` the current resource until the end of the scope. This is
+  // what `with_resource` does around `construct`. Use it directly to
+  // construct somewhere a pre-factory builder can't be wrapped, such as with
+  // `Foo::optional` or when constructing a post-factory builder later.
+  class ResourceScope {
+  public:
+    explicit ResourceScope(std::pmr::memory_resource &resource) noexcept
+      : previous{detail::scoped_resource()}
+    {
+      detail::scoped_resource() = &resource;
+    }
+    ResourceScope(ResourceScope const &) = delete;
+    ResourceScope &operator=(ResourceScope const &) = delete;
+
+    ~ResourceScope() { detail::scoped_resource() = previous; }
+
+  private:
+    std::pmr::memory_resource *previous;
+  };
+
+  namespace detail {
+    template <typename Builder>
+    class ResourceBuilder {
+    public:
+      ResourceBuilder(std::pmr::memory_resource &resource_, Builder builder_)
+        : resource{resource_}
+        , builder{std::move(builder_)}
+      {}
+
+      template <typename OnSuccess, typename OnFail>
+      auto construct(OnSuccess&& on_success, OnFail&& on_fail) && {
+        ResourceScope scope{resource};
+        return std::move(builder).construct(
+          std::forward<OnSuccess>(on_success), std::forward<OnFail>(on_fail)
+        );
+      }
+
+    private:
+      std::pmr::memory_resource &resource;
+      Builder builder;
+    };
+
+    template <typename T>
+    using UsesAllocator = std::uses_allocator<T, Allocator>;
+
+    // Whether `T` declares an `allocator_type` and has a
+    // `(tag, std::allocator_arg, Allocator, args...)` constructor, as
+    // `Helpers` types that allocate do
+    template <typename T, typename Tag, typename ...Args>
+    using TakesAllocator = std::conjunction<
+      UsesAllocator<T>
+    , std::is_constructible<
+        T, Tag, std::allocator_arg_t, Allocator const &, Args...
+      >
+    >;
+
+    inline bool resource_scoped() noexcept {
+      return scoped_resource() != nullptr;
+    }
+  }
+
+  // The resource of the innermost scope, or the default resource
+  inline std::pmr::memory_resource *current_resource() noexcept {
+    auto resource = detail::scoped_resource();
+    return resource ? resource : std::pmr::get_default_resource();
+  }
+
+  // For factories and constructors that allocate themselves
+  inline Allocator current_allocator() noexcept {
+    return Allocator{current_resource()};
+  }
+
+  // A pre-factory builder that constructs `builder` with `resource`. Types
+  // made by `Helpers` receive it if they opt in through `AllocatorHelper`,
+  // and allocator-aware types made by `allocator_wrapper` as an extra brace
+  // initializer (see `brace_construct_with_allocator`). Outside a scope, both
+  // are constructed as if there were no resource.
+  template <typename Builder>
+  inline auto with_resource(
+    std::pmr::memory_resource &resource, Builder builder
+  ) {
+    return detail::ResourceBuilder<Builder>{resource, std::move(builder)};
+  }
+
+  namespace detail {
+    // Calls `make(tag, std::allocator_arg, allocator, args...)` with the
+    // current allocator inside a resource scope, and `make(tag, args...)`
+    // outside one. A `T` that can only be constructed with an allocator always
+    // gets one, which outside a scope uses the default resource.
+    template <typename T, typename Make, typename Tag, typename ...Args>
+    inline auto make_with_allocator(Make make, Tag tag, Args&&... args) {
+      if constexpr (!std::is_constructible<T, Tag, Args...>::value) {
+        return make(
+          tag, std::allocator_arg, current_allocator()
+        , std::forward<Args>(args)...
+        );
+      } else {
+        if (resource_scoped()) {
+          return make(
+            tag, std::allocator_arg, current_allocator()
+          , std::forward<Args>(args)...
+          );
+        }
+        return make(tag, std::forward<Args>(args)...);
+      }
+    }
+
+    template <typename Void, typename T, typename ...Args>
+    struct BraceConstructible : std::false_type {};
+
+    template <typename T, typename ...Args>
+    struct BraceConstructible<
+      decltype(void(T{std::declval<Args>()...})), T, Args...
+    > : std::true_type {};
+
+    template <typename Void, typename T, typename ...Args>
+    struct ListConstructible : std::false_type {};
+
+    // `T{args...}` would pick an initializer list constructor
+    template <typename T, typename Arg, typename ...Args>
+    struct ListConstructible<
+      decltype(void(T(
+        std::initializer_list<typename T::value_type>{
+          std::declval<Arg>(), std::declval<Args>()...
+        }
+      , std::declval<Allocator const &>()
+      ))), T, Arg, Args...
+    > : std::true_type {};
+
+    // `T{args...}`, but with the current allocator. It is passed after a
+    // leading `std::allocator_arg` if `T` takes that, and otherwise last,
+    // except that elements keep going to an initializer list constructor.
+    // Without any of these, the allocator is left out.
+    template <typename T, typename ...Args>
+    inline T brace_construct_with_allocator(Args&&... args) {
+      if constexpr (
+        BraceConstructible<
+          void, T, std::allocator_arg_t, Allocator const &, Args...
+        >::value
+      ) {
+        return T{
+          std::allocator_arg, current_allocator(), std::forward<Args>(args)...
+        };
+      } else if constexpr (ListConstructible<void, T, Args...>::value) {
+        return T(
+          std::initializer_list<typename T::value_type>{
+            std::forward<Args>(args)...
+          }
+        , current_allocator()
+        );
+      } else if constexpr (
+        BraceConstructible<void, T, Args..., Allocator const &>::value
+      ) {
+        return T{std::forward<Args>(args)..., current_allocator()};
+      } else {
+        return T{std::forward<Args>(args)...};
+      }
+    }
+
+    template <typename T>
+    struct AllocatorBraceConstructor {
+      template <typename ...Args>
+      T operator()(Args&&... args) const {
+        if (resource_scoped()) {
+          return brace_construct_with_allocator<T>(
+            std::forward<Args>(args)...
+          );
+        }
+        return T{std::forward<Args>(args)...};
+      }
+    };
+  }
+
+  // Like `wrapper`, but an allocator-aware `T` receives the current allocator
+  // inside a resource scope
+  template <typename T, typename ...Args>
+  inline auto allocator_wrapper(Args&&... args) noexcept {
+    return builder(
+      Factory<T, detail::AllocatorBraceConstructor<T>>{}
+    , std::forward<Args>(args)...
+    );
+  }
+
+  // Passes the current allocator to a `Helpers` type that also derives from
+  // `AllocatorHelper<Helpers<Foo>>` and has a
+  // `Foo(Private, std::allocator_arg_t, Allocator, ...)` constructor. This
+  // covers `Foo::builder` and, for the optional and variant helpers,
+  // `Foo::optional` and `Foo::variant`.
+  template <typename T>
+  class AllocatorHelper {
+  private:
+    friend class BuilderHelper<T>;
+
+    template <typename Make, typename ...Args>
+    static auto make_instance(Make make, Args&&... args) {
+      using U = typename T::Implementation;
+      if constexpr (
+        detail::TakesAllocator<U, typename T::Private, Args...>::value
+      ) {
+        return detail::make_with_allocator<U>(
+          make, typename T::Private{}, std::forward<Args>(args)...
+        );
+      } else {
+        return make(typename T::Private{}, std::forward<Args>(args)...);
+      }
+    }
+  };
+#endif
+}}
+
+#endif
@@ -0,0 +1,271 @@
+#ifndef UUID_8C3F5A27_D94E_4B16_A0E3_5F7B2D9C6E41
+#define UUID_8C3F5A27_D94E_4B16_A0E3_5F7B2D9C6E41
+
+#include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/slot.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace mz { namespace piecewise {
+  // The post-factory builder an `AnyBuilder` passes to its success callback.
+  // Like any post-factory builder, it refers to the frame of the factory that
+  // created it and must not outlive the callback.
+  template <typename T>
+  class AnyPostBuilder {
+  public:
+    using result_type = T;
+
+    AnyPostBuilder(void *builder_, T (*construct_)(void *))
+      : builder{builder_}, construct_erased{construct_}
+    {}
+
+    T construct() && { return construct_erased(builder); }
+
+  private:
+    void *builder;
+    T (*construct_erased)(void *);
+  };
+
+  namespace detail {
+    template <typename T, typename ...Ts>
+    struct Contains : std::false_type {};
+
+    template <typename T, typename U, typename ...Ts>
+    struct Contains<T, U, Ts...>
+      : std::conditional_t<
+          std::is_same<T, U>::value, std::true_type, Contains<T, Ts...>
+        >
+    {};
+
+    // Where an erased builder reports its outcome. `context` belongs to the
+    // `construct` call that is waiting for it.
+    template <typename T, typename ...Errors>
+    struct AnySink {
+      void *context;
+      void (*success)(void *, AnyPostBuilder<T>&);
+      std::tuple<void (*)(void *, Errors&)...> fail;
+    };
+
+    template <typename T, typename ...Errors>
+    struct AnyOperations {
+      void (*construct)(void *, AnySink<T, Errors...>&);
+      void (*move)(void *, void *) noexcept;
+      void (*destroy)(void *) noexcept;
+    };
+
+    template <typename T, typename Builder>
+    inline T construct_post(void *builder) {
+      return std::move(*static_cast<Builder *>(builder)).construct();
+    }
+
+    template <typename T, typename ...Errors, typename Builder>
+    inline void construct_erased(
+      Builder& builder, AnySink<T, Errors...>& sink
+    ) {
+      std::move(builder).construct(
+        [&sink](auto post) {
+          AnyPostBuilder<T> erased{&post, &construct_post<T, decltype(post)>};
+          sink.success(sink.context, erased);
+        }
+      , [&sink](auto error) {
+          static_assert(
+            Contains<decltype(error), Errors...>::value
+          , "The factory can fail with an error that is not in Errors..."
+          );
+          std::get<void (*)(void *, decltype(error)&)>(sink.fail)(
+            sink.context, error
+          );
+        }
+      );
+    }
+
+    // The builder lives in the inline buffer
+    template <typename T, typename Builder, typename ...Errors>
+    struct InlineOperations {
+      static Builder &get(void *storage) {
+        return *static_cast<Builder *>(storage);
+      }
+
+      static void construct(void *storage, AnySink<T, Errors...>& sink) {
+        construct_erased(get(storage), sink);
+      }
+
+      static void move(void *from, void *to) noexcept {
+        ::new (to) Builder(std::move(get(from)));
+        get(from).~Builder();
+      }
+
+      static void destroy(void *storage) noexcept { get(storage).~Builder(); }
+
+      static constexpr AnyOperations<T, Errors...> operations{
+        &construct, &move, &destroy
+      };
+    };
+
+    template <typename T, typename Builder, typename ...Errors>
+    constexpr AnyOperations<T, Errors...>
+      InlineOperations<T, Builder, Errors...>::operations;
+
+    // The buffer holds a pointer to the builder
+    template <typename T, typename Builder, typename ...Errors>
+    struct HeapOperations {
+      static Builder *&get(void *storage) {
+        return *static_cast<Builder **>(storage);
+      }
+
+      static void construct(void *storage, AnySink<T, Errors...>& sink) {
+        construct_erased(*get(storage), sink);
+      }
+
+      static void move(void *from, void *to) noexcept {
+        ::new (to) Builder *(get(from));
+      }
+
+      static void destroy(void *storage) noexcept { delete get(storage); }
+
+      static constexpr AnyOperations<T, Errors...> operations{
+        &construct, &move, &destroy
+      };
+    };
+
+    template <typename T, typename Builder, typename ...Errors>
+    constexpr AnyOperations<T, Errors...>
+      HeapOperations<T, Builder, Errors...>::operations;
+  }
+
+  // A pre-factory builder for a `T` that hides which builder it wraps, so code
+  // that picks a builder at runtime instantiates the machinery that consumes
+  // it once. Any owned pre-factory builder (see `Builder::own`) whose
+  // post-factory builder constructs something convertible to `T`, and whose
+  // factory only fails with `Errors...`, can be stored. Builders of up to
+  // `inline_size` bytes that move without throwing are stored inline, and
+  // larger ones on the heap. Construction costs one indirect call for the
+  // factory and one for the constructor. A default constructed or moved-from
+  // `AnyBuilder` is empty, and must be assigned a builder before `construct`.
+  template <typename T, typename ...Errors>
+  class AnyBuilder {
+  public:
+    static constexpr std::size_t inline_size = 8 * sizeof(void *);
+
+    template <typename Builder>
+    static constexpr bool fits_inline() {
+      return sizeof(Builder) <= inline_size
+        && alignof(Builder) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible<Builder>::value;
+    }
+
+    AnyBuilder() noexcept = default;
+
+    // Takes ownership of the arguments of `builder`, so the result can be
+    // returned from the function that chose it
+    template <
+      typename Builder
+    , typename = std::enable_if_t<
+        detail::IsBuilder<std::decay_t<Builder>>::value
+      >
+    > explicit AnyBuilder(Builder&& builder)
+      : AnyBuilder{
+          std::decay_t<Builder>{std::forward<Builder>(builder)}.own()
+        , 0
+        }
+    {}
+
+    AnyBuilder(AnyBuilder&& other) noexcept : operations{other.operations} {
+      if (operations) operations->move(&other.storage, &storage);
+      other.operations = nullptr;
+    }
+
+    AnyBuilder &operator=(AnyBuilder&& other) noexcept {
+      if (this != &other) {
+        reset();
+        operations = other.operations;
+        if (operations) operations->move(&other.storage, &storage);
+        other.operations = nullptr;
+      }
+      return *this;
+    }
+
+    ~AnyBuilder() { reset(); }
+
+    // Whether a builder is held
+    explicit operator bool() const noexcept { return operations != nullptr; }
+
+    template <typename OnSuccess, typename OnFail>
+    auto construct(OnSuccess&& on_success, OnFail&& on_fail) && {
+      assert(operations != nullptr && "construct on an empty AnyBuilder");
+      using Result = decltype(
+        on_success(std::declval<AnyPostBuilder<T>>())
+      );
+      ConstructContext<Result, OnSuccess, OnFail> context{
+        on_success, on_fail, {}
+      };
+      detail::AnySink<T, Errors...> sink{
+        &context
+      , &succeed<decltype(context)>
+      , std::make_tuple(&fail<decltype(context), Errors>...)
+      };
+      operations->construct(&storage, sink);
+      return context.result.take();
+    }
+
+  private:
+    template <typename Owned>
+    AnyBuilder(Owned owned, int) {
+      emplace(std::move(owned), std::integral_constant<
+        bool, fits_inline<Owned>()
+      >{});
+    }
+
+    template <typename Owned>
+    void emplace(Owned owned, std::true_type) {
+      ::new (static_cast<void *>(&storage)) Owned(std::move(owned));
+      operations = &detail::InlineOperations<T, Owned, Errors...>::operations;
+    }
+
+    template <typename Owned>
+    void emplace(Owned owned, std::false_type) {
+      ::new (static_cast<void *>(&storage)) Owned *(
+        new Owned(std::move(owned))
+      );
+      operations = &detail::HeapOperations<T, Owned, Errors...>::operations;
+    }
+
+    void reset() noexcept {
+      if (operations) operations->destroy(&storage);
+      operations = nullptr;
+    }
+
+    template <typename Result, typename OnSuccess, typename OnFail>
+    struct ConstructContext {
+      OnSuccess& on_success;
+      OnFail& on_fail;
+      detail::Slot<Result> result;
+    };
+
+    template <typename Context>
+    static void succeed(void *context_, AnyPostBuilder<T>& builder) {
+      auto &context = *static_cast<Context *>(context_);
+      context.result.fill([&]() -> decltype(auto) {
+        return context.on_success(std::move(builder));
+      });
+    }
+
+    template <typename Context, typename Error>
+    static void fail(void *context_, Error& error) {
+      auto &context = *static_cast<Context *>(context_);
+      context.result.fill([&]() -> decltype(auto) {
+        return context.on_fail(std::move(error));
+      });
+    }
+
+    detail::AnyOperations<T, Errors...> const *operations = nullptr;
+    std::aligned_storage_t<inline_size, alignof(std::max_align_t)> storage;
+  };
+}}
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef UUID_9C1E4A7B_25D6_4F83_B0A9_E47D13C8256F
+#define UUID_9C1E4A7B_25D6_4F83_B0A9_E47D13C8256F
+
+#include <mz/piecewise/helpers.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mz { namespace piecewise {
+  // Points to an object that lives in an `Arena`. The arena owns the object,
+  // so this is just a pointer that can't be deleted.
+  template <typename T>
+  class ArenaPtr {
+  public:
+    ArenaPtr() = default;
+    explicit ArenaPtr(T *pointer_) : pointer{pointer_} {}
+
+    T *get() const { return pointer; }
+    T &operator*() const { return *pointer; }
+    T *operator->() const { return pointer; }
+    explicit operator bool() const { return pointer != nullptr; }
+
+  private:
+    T *pointer = nullptr;
+  };
+
+  // A monotonic arena. Objects are placed one after another in the order
+  // they are constructed, and all of them are destroyed at once when the arena
+  // is released or destroyed. Objects are destroyed in the reverse order of
+  // their construction finishing, so owners go before their members.
+  class Arena {
+  public:
+    explicit Arena(std::size_t block_size_ = 4096) : block_size{block_size_} {}
+    Arena(Arena const &) = delete;
+    Arena &operator=(Arena const &) = delete;
+
+    ~Arena() { release(); }
+
+    void *allocate(std::size_t size, std::size_t alignment) {
+      auto padding = padding_for(cursor, alignment);
+      if (
+        blocks == nullptr
+        || padding + size > static_cast<std::size_t>(end - cursor)
+      ) {
+        add_block(size + alignment);
+        padding = padding_for(cursor, alignment);
+      }
+      auto start = cursor + padding;
+      cursor = start + size;
+      return start;
+    }
+
+    // Places the object of a post-factory builder in the arena. Any extra
+    // arguments are passed to the constructor ahead of the builder's own.
+    template <typename Builder, typename ...Extra>
+    auto construct(Builder builder, Extra&&... extra) {
+      using T = decltype(
+        std::declval<Builder>().construct(std::declval<Extra>()...)
+      );
+      Cleanup *cleanup = nullptr;
+      if (!std::is_trivially_destructible<T>::value) {
+        cleanup = ::new (allocate(sizeof(Cleanup), alignof(Cleanup))) Cleanup{
+          nullptr, &destroy<T>, nullptr
+        };
+      }
+      auto object = static_cast<T *>(allocate(sizeof(T), alignof(T)));
+      ::new (static_cast<void *>(object)) T(
+        std::move(builder).construct(std::forward<Extra>(extra)...)
+      );
+      // Linked only now, after anything the constructor placed, so that an
+      // object is destroyed before its members
+      if (cleanup != nullptr) {
+        cleanup->previous = cleanups;
+        cleanup->object = object;
+        cleanups = cleanup;
+      }
+      return ArenaPtr<T>{object};
+    }
+
+    // Destroys every object and frees every block
+    void release() {
+      while (cleanups != nullptr) {
+        cleanups->destroy(cleanups->object);
+        cleanups = cleanups->previous;
+      }
+      while (blocks != nullptr) {
+        auto previous = blocks->previous;
+        ::operator delete(blocks);
+        blocks = previous;
+      }
+      cursor = nullptr;
+      end = nullptr;
+    }
+
+  private:
+    struct Block {
+      Block *previous;
+    };
+
+    struct Cleanup {
+      Cleanup *previous;
+      void (*destroy)(void *);
+      void *object;
+    };
+
+    template <typename T>
+    static void destroy(void *object) { static_cast<T *>(object)->~T(); }
+
+    static std::size_t padding_for(char *pointer, std::size_t alignment) {
+      auto address = reinterpret_cast<std::uintptr_t>(pointer);
+      return (alignment - address % alignment) % alignment;
+    }
+
+    void add_block(std::size_t minimum) {
+      auto const needed = sizeof(Block) + minimum;
+      auto const size = needed > block_size ? needed : block_size;
+      auto block = static_cast<Block *>(::operator new(size));
+      block->previous = blocks;
+      blocks = block;
+      cursor = reinterpret_cast<char *>(block) + sizeof(Block);
+      end = reinterpret_cast<char *>(block) + size;
+    }
+
+    std::size_t block_size;
+    Block *blocks = nullptr;
+    Cleanup *cleanups = nullptr;
+    char *cursor = nullptr;
+    char *end = nullptr;
+  };
+
+  // Adds `Foo::arena` to a `Helpers` type that also derives from
+  // `ArenaHelper<Helpers<Foo>>`
+  template <typename T>
+  class ArenaHelper {
+  public:
+    template <typename Builder>
+    class Placement final {
+    private:
+      Arena &arena;
+      Builder builder;
+
+    public:
+      Placement(Arena &arena_, Builder builder_)
+        : arena(arena_), builder(std::move(builder_))
+      {}
+
+      // A constructor that takes the arena as its first argument after the
+      // private tag receives it, so that it can place its own members there
+      // too. Other constructors are called as usual.
+      template <typename ErrorCallback>
+      auto construct(ErrorCallback &&error_callback) && {
+        using Pointer = ArenaPtr<typename T::Implementation>;
+        return std::move(builder).construct(
+          [&](auto builder_) -> Pointer {
+            return arena.construct(
+              std::move(builder_), detail::OptionalArgument<Arena>{arena}
+            );
+          }
+        , [&](auto error) {
+            error_callback(error);
+            return Pointer{};
+          }
+        );
+      }
+    };
+
+    template <typename Builder>
+    static auto placement_helper(Arena &arena, Builder builder) {
+      return Placement<Builder>(arena, std::move(builder));
+    }
+
+    template <typename ...Args>
+    static auto arena(Arena &arena_, Args&&... args) {
+      return placement_helper(
+        arena_, BuilderHelper<T>::builder(std::forward<Args>(args)...)
+      );
+    }
+  };
+}}
+
+#endif
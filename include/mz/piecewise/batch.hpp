@@ -0,0 +1,229 @@
+#ifndef UUID_B4E7193D_5A2C_4C68_8F01_D2A69E3B7C58
+#define UUID_B4E7193D_5A2C_4C68_8F01_D2A69E3B7C58
+
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/in_place.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mz { namespace piecewise {
+  namespace detail {
+    template <typename MakeBuilder, typename Row, std::size_t ...Indices>
+    inline auto row_builder(
+      MakeBuilder& make_builder
+    , Row const& row
+    , std::index_sequence<Indices...>
+    ) {
+      return make_builder(std::get<Indices>(row)...);
+    }
+
+    // Constructs the rows in [first, last), whose first row has index `index`
+    template <
+      typename T, typename Iterator
+    , typename MakeBuilder, typename OnFail
+    > inline void construct_rows(
+      std::vector<T>& instances
+    , Iterator first, Iterator last, std::size_t index
+    , MakeBuilder& make_builder, OnFail& on_fail
+    ) {
+      for (; first != last; ++first, ++index) {
+        using Row = std::decay_t<decltype(*first)>;
+        row_builder(
+          make_builder, *first
+        , std::make_index_sequence<std::tuple_size<Row>::value>{}
+        ).construct(
+          [&](auto builder) {
+            detail::emplace_with(
+              [&](auto&&... args) {
+                instances.emplace_back(std::forward<decltype(args)>(args)...);
+              }
+            , std::move(builder)
+            );
+          }
+        , [&](auto error) { on_fail(index, std::move(error)); }
+        );
+      }
+    }
+
+    // Shared by the calling thread and every submitted task, so that tasks the
+    // executor runs after `construct_batch` returned only touch this.
+    class BatchShared {
+    public:
+      BatchShared(
+        std::size_t chunks_
+      , void *work_, void (*run_)(void *, std::size_t)
+      ) : chunks{chunks_}, work{work_}, run{run_}
+      {}
+
+      // Claims and runs chunks until none are left. The first exception a
+      // chunk throws is kept for `wait`, and chunks claimed after it are
+      // skipped.
+      void help() {
+        for (;;) {
+          auto chunk = next++;
+          if (chunk >= chunks) return;
+          if (!failed) {
+            try {
+              run(work, chunk);
+            } catch (...) {
+              std::lock_guard<std::mutex> lock{mutex};
+              if (!exception) exception = std::current_exception();
+              failed = true;
+            }
+          }
+          std::lock_guard<std::mutex> lock{mutex};
+          if (++finished == chunks) condition.notify_all();
+        }
+      }
+
+      // Returns once every chunk is done, so nothing references the caller's
+      // frame anymore, then rethrows the first exception
+      void wait() {
+        {
+          std::unique_lock<std::mutex> lock{mutex};
+          condition.wait(lock, [this] { return finished == chunks; });
+        }
+        if (exception) std::rethrow_exception(exception);
+      }
+
+    private:
+      std::size_t const chunks;
+      void *const work;
+      void (*const run)(void *, std::size_t);
+      std::atomic<std::size_t> next{0};
+      std::mutex mutex;
+      std::condition_variable condition;
+      std::size_t finished = 0;
+      std::atomic<bool> failed{false};
+      std::exception_ptr exception;
+    };
+  }
+
+  // Constructs one `T` per row, in row order, into a vector that is reserved
+  // up front. Each row is a tuple of arguments for `make_builder`, which
+  // returns a pre-factory builder. `on_fail(row_index, error)` is called for
+  // every row whose factory fails.
+  template <
+    typename T, typename Rows
+  , typename MakeBuilder, typename OnFail
+  > inline std::vector<T> construct_batch(
+    Rows const& rows, MakeBuilder make_builder, OnFail&& on_fail
+  ) {
+    std::vector<T> instances;
+    instances.reserve(static_cast<std::size_t>(
+      std::distance(std::begin(rows), std::end(rows))
+    ));
+    detail::construct_rows(
+      instances
+    , std::begin(rows), std::end(rows), 0
+    , make_builder, on_fail
+    );
+    return instances;
+  }
+
+  // Like the sequential version, but splits the rows into `chunks` contiguous
+  // chunks that run on `executor` (see `parallel_multifail`). The calling
+  // thread works on chunks too. Calls to `on_fail` are serialized, but not
+  // ordered. The instances of each chunk are moved into the result once. If a
+  // row throws, the remaining chunks are skipped and the first exception is
+  // rethrown on the calling thread once no chunk is running.
+  template <
+    typename T, typename Executor, typename Rows
+  , typename MakeBuilder, typename OnFail
+  > inline std::vector<T> construct_batch(
+    Executor&& executor
+  , Rows const& rows, MakeBuilder make_builder, OnFail&& on_fail
+  , std::size_t chunks = std::thread::hardware_concurrency()
+  ) {
+    auto first = std::begin(rows);
+    auto count = static_cast<std::size_t>(
+      std::distance(first, std::end(rows))
+    );
+    chunks = std::max<std::size_t>(1, std::min(chunks, count));
+
+    std::vector<std::vector<T>> parts(chunks);
+    std::mutex fail_mutex;
+    auto serialized_fail = [&](std::size_t index, auto error) {
+      std::lock_guard<std::mutex> lock{fail_mutex};
+      on_fail(index, std::move(error));
+    };
+    auto run_chunk = [&](std::size_t chunk) {
+      auto begin = count * chunk / chunks;
+      auto end = count * (chunk + 1) / chunks;
+      parts[chunk].reserve(end - begin);
+      detail::construct_rows(
+        parts[chunk]
+      , std::next(first, static_cast<std::ptrdiff_t>(begin))
+      , std::next(first, static_cast<std::ptrdiff_t>(end))
+      , begin
+      , make_builder, serialized_fail
+      );
+    };
+
+    auto shared = std::make_shared<detail::BatchShared>(
+      chunks
+    , &run_chunk
+    , [](void *work, std::size_t chunk) {
+        (*static_cast<decltype(run_chunk) *>(work))(chunk);
+      }
+    );
+    for (std::size_t i = 1; i < chunks; ++i) {
+      executor([shared] { shared->help(); });
+    }
+    shared->help();
+    shared->wait();
+
+    std::vector<T> instances;
+    std::size_t total = 0;
+    for (auto &part : parts) total += part.size();
+    instances.reserve(total);
+    for (auto &part : parts) {
+      std::move(part.begin(), part.end(), std::back_inserter(instances));
+    }
+    return instances;
+  }
+
+  // Adds `Foo::batch` to a `Helpers` type that also derives from
+  // `BatchHelper<Helpers<Foo>>`
+  template <typename T>
+  class BatchHelper {
+  private:
+    static auto make_builder() {
+      return [](auto const&... args) {
+        return BuilderHelper<T>::builder(args...);
+      };
+    }
+
+  public:
+    // Constructs one instance per row of arguments (see `construct_batch`)
+    template <typename Rows, typename ErrorCallback>
+    static auto batch(Rows const &rows, ErrorCallback &&error_callback) {
+      return construct_batch<typename T::Implementation>(
+        rows, make_builder(), std::forward<ErrorCallback>(error_callback)
+      );
+    }
+
+    template <typename Executor, typename Rows, typename ErrorCallback>
+    static auto batch(
+      Executor &&executor, Rows const &rows, ErrorCallback &&error_callback
+    ) {
+      return construct_batch<typename T::Implementation>(
+        std::forward<Executor>(executor)
+      , rows, make_builder(), std::forward<ErrorCallback>(error_callback)
+      );
+    }
+  };
+}}
+
+#endif
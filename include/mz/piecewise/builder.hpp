@@ -3,44 +3,180 @@
 
 #include <mz/piecewise/forward_tuple.hpp>
 
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 namespace mz { namespace piecewise {
+  template <typename ConstructCallback, typename ...Forwards>
+  class Builder;
+
+  template <typename T, typename View>
+  class Owned;
+
+  namespace detail {
+    template <typename T>
+    struct IsBuilder : std::false_type {};
+
+    template <typename ConstructCallback, typename ...Forwards>
+    struct IsBuilder<Builder<ConstructCallback, Forwards...>>
+      : std::true_type
+    {};
+
+    template <typename T>
+    struct Owning {
+      using type = T;
+    };
+
+    template <typename T, typename View>
+    struct Owning<Owned<T, View>> {
+      using type = T;
+    };
+
+    // Nested pre-factory builders are owned recursively
+    template <typename T>
+    inline auto own_argument(T&& arg, std::true_type) {
+      return std::decay_t<T>{std::forward<T>(arg)}.own();
+    }
+
+    // Borrowed arguments (see `owned`) are copied into what they convert to
+    template <typename T>
+    inline typename Owning<std::decay_t<T>>::type own_argument(
+      T&& arg, std::false_type
+    ) {
+      return std::forward<T>(arg);
+    }
+
+    template <typename T>
+    inline auto own_argument(T&& arg) {
+      return own_argument(
+        std::forward<T>(arg), IsBuilder<std::decay_t<T>>{}
+      );
+    }
+  }
+
   template <typename ConstructCallback, typename ...Forwards>
   class Builder {
   public:
-    Builder(ConstructCallback callback_, std::tuple<Forwards...> packed_args_)
-      : packed_args{std::move(packed_args_)}
+    constexpr Builder(
+      ConstructCallback callback_, std::tuple<Forwards...> packed_args_
+    ) noexcept(
+      std::is_nothrow_move_constructible<std::tuple<Forwards...>>::value
+      && std::is_nothrow_move_constructible<ConstructCallback>::value
+    ) : packed_args{std::move(packed_args_)}
       , callback{std::move(callback_)}
     {}
 
+    // Unpacks in place rather than through `forward_tuple`, which would move
+    // the arguments into another tuple and add a level of instantiations
     template <typename ...Args>
-    auto construct(Args&&... args) && {
-      return forward_tuple(
+    constexpr auto construct(Args&&... args) && noexcept(noexcept(
+      detail::unpack_tuple(
+        callback
+      , std::move(packed_args)
+      , std::index_sequence_for<Forwards...>{}
+      , std::forward<Args>(args)...
+      )
+    )) {
+      return detail::unpack_tuple(
         callback
       , std::move(packed_args)
+      , std::index_sequence_for<Forwards...>{}
       , std::forward<Args>(args)...
       );
     }
 
+    // Moves rvalue arguments and copies lvalue arguments into a builder that
+    // owns them, so it can outlive the scope that created it. Wrap arguments
+    // that should stay references in `std::ref`. The callback is moved as it
+    // is, so whatever a callback refers to must still outlive the result,
+    // such as the `Reusable` behind its builders (see reload.hpp).
+    auto own() && {
+      return own(std::index_sequence_for<Forwards...>{});
+    }
+
   private:
+    template <std::size_t ...Indices>
+    auto own(std::index_sequence<Indices...>) {
+      using Owned = Builder<
+        ConstructCallback
+      , decltype(detail::own_argument(std::declval<Forwards>()))...
+      >;
+      return Owned{
+        std::move(callback)
+      , std::make_tuple(
+          detail::own_argument(std::get<Indices>(std::move(packed_args)))...
+        )
+      };
+    }
+
     std::tuple<Forwards...> packed_args;
     ConstructCallback callback;
   };
 
   template <typename ConstructCallback, typename ...Forwards>
-  inline auto make_builder(
+  constexpr auto make_builder(
     ConstructCallback callback
   , std::tuple<Forwards...> packed_args
+  ) noexcept(
+    std::is_nothrow_constructible<
+      Builder<ConstructCallback, Forwards...>
+    , ConstructCallback, std::tuple<Forwards...>
+    >::value
   )-> Builder<ConstructCallback, Forwards...> {
     return {std::move(callback), std::move(packed_args)};
   }
 
   template <typename ConstructCallback, typename ...Args>
-  inline auto builder(ConstructCallback callback, Args&&... args) {
+  constexpr auto builder(ConstructCallback callback, Args&&... args) noexcept(
+    noexcept(
+      make_builder(
+        std::move(callback)
+      , std::forward_as_tuple(std::forward<Args>(args)...)
+      )
+    )
+  ) {
     return make_builder(
       std::move(callback)
     , std::forward_as_tuple(std::forward<Args>(args)...)
     );
   }
+
+  // Like `builder`, but the arguments are decayed and stored in the builder
+  // (see `Builder::own`) instead of referred to, so it can be moved to another
+  // thread and constructed there later. Nested pre-factory builders are owned
+  // recursively. Nothing is allocated beyond what the arguments themselves
+  // allocate when they are moved or copied.
+  template <typename ConstructCallback, typename ...Args>
+  inline auto owning_builder(ConstructCallback callback, Args&&... args) {
+    return make_builder(
+      std::move(callback)
+    , std::make_tuple(detail::own_argument(std::forward<Args>(args))...)
+    );
+  }
+
+  // A borrowed argument, such as a `std::string_view` that a factory
+  // validated, that converts to the owning `T` it was borrowed for. Passed to
+  // the post-factory builder in place of a `T`, the owning copy is only made
+  // when the constructor is invoked, so nothing is copied if any factory of
+  // the aggregate fails. Like builders, it refers to the view, and owning
+  // builders (see `own`) store the `T` instead.
+  template <typename T, typename View>
+  class Owned {
+  public:
+    constexpr explicit Owned(View const &view_) noexcept : view(view_) {}
+
+    operator T() const { return T(view); }
+
+  private:
+    View const &view;
+  };
+
+  template <typename T, typename View>
+  constexpr Owned<T, View> owned(View const &view) noexcept {
+    return Owned<T, View>{view};
+  }
 }}
 
 #endif
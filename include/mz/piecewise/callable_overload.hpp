@@ -16,7 +16,9 @@ namespace mz { namespace piecewise {
     using Lambda::operator();
     using CallableOverload<Lambdas...>::operator();
     template <typename ForwardLambda, typename ...ForwardLambdas>
-    CallableOverload(ForwardLambda&& lambda, ForwardLambdas&&... lambdas)
+    constexpr CallableOverload(
+      ForwardLambda&& lambda, ForwardLambdas&&... lambdas
+    )
       : Lambda{std::forward<ForwardLambda>(lambda)}
       , CallableOverload<Lambdas...>{std::forward<ForwardLambdas>(lambdas)...}
     {}
@@ -25,12 +27,12 @@ namespace mz { namespace piecewise {
   template <typename Lambda>
   struct CallableOverload<Lambda> : Lambda {
     using Lambda::operator();
-    CallableOverload(Lambda lambda) : Lambda{std::move(lambda)} {}
+    constexpr CallableOverload(Lambda lambda) : Lambda{std::move(lambda)} {}
   };
 #endif
 
   template <typename ...ForwardLambdas>
-  auto handler(ForwardLambdas&&... lambdas) {
+  constexpr auto handler(ForwardLambdas&&... lambdas) {
     return CallableOverload<std::remove_reference_t<ForwardLambdas>...>{
       std::forward<ForwardLambdas>(lambdas)...
     };
@@ -0,0 +1,185 @@
+#ifndef UUID_E0B6F3A8_57C2_4D1E_A9F4_2B8C61D07E35
+#define UUID_E0B6F3A8_57C2_4D1E_A9F4_2B8C61D07E35
+
+#include <mz/piecewise/trace.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mz { namespace piecewise {
+  // A tracer (see trace.hpp) that times every factory and constructor with a
+  // monotonic clock and exports them in the Chrome trace event format, for
+  // chrome://tracing or Perfetto. Events from all threads are collected
+  // process-wide until `clear` is called.
+  class ChromeTracer final {
+  public:
+    template <typename T>
+    static void factory_start(std::size_t depth) {
+      start(factory_starts(), depth);
+    }
+
+    template <typename T>
+    static void factory_success(std::size_t depth) {
+      finish(factory_starts(), depth, type_name<T>(), "factory", nullptr);
+    }
+
+    template <typename T, typename Error>
+    static void factory_failure(std::size_t depth, Error const &) {
+      finish(
+        factory_starts(), depth, type_name<T>(), "factory", type_name<Error>()
+      );
+    }
+
+    template <typename T>
+    static void constructor_start(std::size_t depth) {
+      start(constructor_starts(), depth);
+    }
+
+    template <typename T>
+    static void constructor_end(std::size_t depth) {
+      finish(
+        constructor_starts(), depth, type_name<T>(), "constructor", nullptr
+      );
+    }
+
+    static std::size_t size() {
+      std::lock_guard<std::mutex> lock{events().mutex};
+      return events().list.size();
+    }
+
+    static void clear() {
+      std::lock_guard<std::mutex> lock{events().mutex};
+      events().list.clear();
+    }
+
+    static void write(std::ostream &out) {
+      std::lock_guard<std::mutex> lock{events().mutex};
+      out << "{\"traceEvents\":[";
+      char const *separator = "\n";
+      for (auto const &event : events().list) {
+        out << separator
+            << "{\"name\":\"" << escape(event.name)
+            << "\",\"cat\":\"" << event.category
+            << "\",\"ph\":\"X\",\"ts\":" << event.start
+            << ",\"dur\":" << event.duration
+            << ",\"pid\":1,\"tid\":" << event.thread
+            << ",\"args\":{\"depth\":" << event.depth;
+        if (event.error) {
+          out << ",\"error\":\"" << escape(event.error) << "\"";
+        }
+        out << "}}";
+        separator = ",\n";
+      }
+      out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+    // Returns false if the file could not be written
+    static bool write(std::string const &path) {
+      std::ofstream out{path};
+      if (!out) return false;
+      write(out);
+      out.close();
+      return !out.fail();
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+      char const *name;
+      char const *category;
+      char const *error;
+      double start;
+      double duration;
+      std::size_t depth;
+      std::size_t thread;
+    };
+
+    struct Events {
+      std::mutex mutex;
+      std::vector<Event> list;
+    };
+
+    static Events &events() {
+      static Events instance;
+      return instance;
+    }
+
+    static Clock::time_point epoch() {
+      static Clock::time_point const instance = Clock::now();
+      return instance;
+    }
+
+    // Start times indexed by depth, so nested events don't need their own
+    // bookkeeping
+    static std::vector<Clock::time_point> &factory_starts() {
+      static thread_local std::vector<Clock::time_point> instance;
+      return instance;
+    }
+
+    static std::vector<Clock::time_point> &constructor_starts() {
+      static thread_local std::vector<Clock::time_point> instance;
+      return instance;
+    }
+
+    static std::size_t thread_index() {
+      static std::atomic<std::size_t> next{1};
+      static thread_local std::size_t const index = next++;
+      return index;
+    }
+
+    static double microseconds(Clock::duration duration) {
+      return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    static void start(
+      std::vector<Clock::time_point> &starts, std::size_t depth
+    ) {
+      epoch();
+      if (starts.size() <= depth) starts.resize(depth + 1);
+      starts[depth] = Clock::now();
+    }
+
+    static void finish(
+      std::vector<Clock::time_point> &starts, std::size_t depth
+    , char const *name, char const *category, char const *error
+    ) {
+      auto now = Clock::now();
+      auto begin = starts[depth];
+      Event event{
+        name, category, error
+      , microseconds(begin - epoch()), microseconds(now - begin)
+      , depth, thread_index()
+      };
+      std::lock_guard<std::mutex> lock{events().mutex};
+      events().list.push_back(event);
+    }
+
+    static std::string escape(char const *text) {
+      static char const hex[] = "0123456789abcdef";
+      std::string escaped;
+      for (; *text; ++text) {
+        auto c = static_cast<unsigned char>(*text);
+        if (c == '"' || c == '\\') {
+          escaped += '\\';
+          escaped += static_cast<char>(c);
+        } else if (c < 0x20) {
+          escaped += "\\u00";
+          escaped += hex[c >> 4];
+          escaped += hex[c & 0xf];
+        } else {
+          escaped += static_cast<char>(c);
+        }
+      }
+      return escaped;
+    }
+  };
+}}
+
+#endif
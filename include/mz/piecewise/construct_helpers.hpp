@@ -3,16 +3,29 @@
 
 #include <utility>
 
+// Lambdas are only literal types since C++17
+#if __cplusplus >= 201703L
+  #define MZ_PIECEWISE_CONSTEXPR_LAMBDA constexpr
+#else
+  #define MZ_PIECEWISE_CONSTEXPR_LAMBDA
+#endif
+
 namespace mz { namespace piecewise {
   template <typename T>
-  auto construct = [](auto... args) {
-    return T(std::forward<decltype(args)>(args)...);
-  };
+  MZ_PIECEWISE_CONSTEXPR_LAMBDA auto construct =
+    [](auto... args) noexcept(noexcept(
+      T(std::forward<decltype(args)>(args)...)
+    )) {
+      return T(std::forward<decltype(args)>(args)...);
+    };
 
   template <typename T>
-  auto braced_construct = [](auto... args) {
-    return T{std::forward<decltype(args)>(args)...};
-  };
+  MZ_PIECEWISE_CONSTEXPR_LAMBDA auto braced_construct =
+    [](auto... args) noexcept(noexcept(
+      T{std::forward<decltype(args)>(args)...}
+    )) {
+      return T{std::forward<decltype(args)>(args)...};
+    };
 }}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,225 @@
+#ifndef UUID_7C3F9A52_1D6E_4B84_A0F7_5E28B4C96D13
+#define UUID_7C3F9A52_1D6E_4B84_A0F7_5E28B4C96D13
+
+#include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/slot.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// A deadline applies to everything a pre-factory builder's `construct` runs on
+// the calling thread, including nested factories and the callbacks. Factories
+// run in continuation passing style, so that is the whole construction of the
+// aggregate. Work handed to other threads, such as by `multifail_async`, has to
+// be given a deadline of its own.
+namespace mz { namespace piecewise {
+  using DeadlineClock = std::chrono::steady_clock;
+
+  struct TimeoutError {
+    static constexpr auto description = "Construction deadline expired";
+  };
+
+  namespace detail {
+    // The earliest deadline in effect on this thread, or the maximum time
+    // point if there isn't one
+    inline DeadlineClock::time_point &current_deadline() noexcept {
+      static thread_local auto deadline = DeadlineClock::time_point::max();
+      return deadline;
+    }
+
+    // Tightens the current deadline until the end of the scope. An inner
+    // budget never extends an outer one.
+    class DeadlineScope {
+    public:
+      explicit DeadlineScope(DeadlineClock::time_point deadline) noexcept
+        : previous{current_deadline()}
+      {
+        current_deadline() = (std::min)(previous, deadline);
+      }
+      DeadlineScope(DeadlineScope const &) = delete;
+      DeadlineScope &operator=(DeadlineScope const &) = delete;
+
+      ~DeadlineScope() { current_deadline() = previous; }
+
+    private:
+      DeadlineClock::time_point previous;
+    };
+
+    template <typename Rep, typename Period>
+    inline DeadlineClock::time_point deadline_after(
+      std::chrono::duration<Rep, Period> budget
+    ) noexcept {
+      auto now = DeadlineClock::now();
+      // Compared in the budget's units, which are usually coarser, so that
+      // large budgets don't overflow
+      auto left = std::chrono::duration_cast<
+        std::chrono::duration<Rep, Period>
+      >(DeadlineClock::time_point::max() - now);
+      if (budget <= budget.zero()) return now;
+      if (budget >= left) return DeadlineClock::time_point::max();
+      return now + std::chrono::duration_cast<DeadlineClock::duration>(budget);
+    }
+
+    // Fails with `TimeoutError` instead of invoking the builder once the
+    // deadline has passed
+    template <typename Builder>
+    class DeadlineBuilder {
+    public:
+      DeadlineBuilder(DeadlineClock::time_point deadline_, Builder builder_)
+        : deadline{deadline_}
+        , builder{std::move(builder_)}
+      {}
+
+      template <typename OnSuccess, typename OnFail>
+      auto construct(OnSuccess&& on_success, OnFail&& on_fail) && {
+        DeadlineScope scope{deadline};
+        if (DeadlineClock::now() >= current_deadline()) {
+          return on_fail(TimeoutError{});
+        }
+        return std::move(builder).construct(
+          std::forward<OnSuccess>(on_success), std::forward<OnFail>(on_fail)
+        );
+      }
+
+    private:
+      DeadlineClock::time_point deadline;
+      Builder builder;
+    };
+
+    template <typename Make, typename OnSuccess, typename OnFail>
+    using RetryResult = decltype(
+      std::declval<Make&>()().construct(
+        std::declval<OnSuccess&>(), std::declval<OnFail&>()
+      )
+    );
+  }
+
+  // The time left before the current deadline, or the maximum duration if
+  // there isn't one. Factories can use this to bound blocking work.
+  inline DeadlineClock::duration remaining_time() noexcept {
+    auto deadline = detail::current_deadline();
+    if (deadline == DeadlineClock::time_point::max()) {
+      return DeadlineClock::duration::max();
+    }
+    auto now = DeadlineClock::now();
+    if (now >= deadline) return DeadlineClock::duration::zero();
+    return deadline - now;
+  }
+
+  inline bool deadline_expired() noexcept {
+    return DeadlineClock::now() >= detail::current_deadline();
+  }
+
+  // A pre-factory builder that gives `builder` at most `budget` to construct.
+  // If the budget has already run out, it fails with `TimeoutError` without
+  // invoking `builder`.
+  template <typename Rep, typename Period, typename Builder>
+  inline auto with_deadline(
+    std::chrono::duration<Rep, Period> budget, Builder builder
+  ) {
+    return detail::DeadlineBuilder<Builder>{
+      detail::deadline_after(budget), std::move(builder)
+    };
+  }
+
+  template <typename Builder>
+  inline auto with_deadline(
+    DeadlineClock::time_point deadline, Builder builder
+  ) {
+    return detail::DeadlineBuilder<Builder>{deadline, std::move(builder)};
+  }
+
+  // Like `builders`, but `multifail` stops at the first of these that it
+  // reaches after the current deadline, and fails with `TimeoutError`
+  template <typename ...Builders>
+  inline auto deadline_builders(Builders... builders) {
+    return std::tuple<detail::DeadlineBuilder<Builders>...>{
+      detail::DeadlineBuilder<Builders>{
+        DeadlineClock::time_point::max(), std::move(builders)
+      }...
+    };
+  }
+
+  // How `retry` spaces its attempts. The delay starts at `initial_delay` and is
+  // multiplied by `factor` after every failure, up to `max_delay`. Zero
+  // `max_attempts` means retrying until the deadline.
+  struct Backoff {
+    std::chrono::milliseconds initial_delay{10};
+    std::chrono::milliseconds max_delay{1000};
+    unsigned factor = 2;
+    unsigned max_attempts = 5;
+  };
+
+  namespace detail {
+    template <typename Make>
+    class RetryBuilder {
+    public:
+      RetryBuilder(Backoff backoff_, Make make_)
+        : backoff{backoff_}
+        , make{std::move(make_)}
+      {}
+
+      // Attempts run one after another in a loop, so waiting between them
+      // doesn't grow the stack. Only the final failure reaches `on_fail`.
+      template <typename OnSuccess, typename OnFail>
+      auto construct(OnSuccess&& on_success, OnFail&& on_fail) && {
+        Slot<RetryResult<Make, OnSuccess, OnFail>> result;
+        auto delay = backoff.initial_delay;
+        for (unsigned number = 1;; ++number) {
+          if (deadline_expired()) {
+            result.fill([&]() -> decltype(auto) {
+              return on_fail(TimeoutError{});
+            });
+            break;
+          }
+          auto last = backoff.max_attempts != 0
+            && number >= backoff.max_attempts;
+          make().construct(
+            [&](auto&& builder) {
+              result.fill([&]() -> decltype(auto) {
+                return on_success(std::forward<decltype(builder)>(builder));
+              });
+            }
+          , [&](auto&& error) {
+              if (!last) return;
+              result.fill([&]() -> decltype(auto) {
+                return on_fail(std::forward<decltype(error)>(error));
+              });
+            }
+          );
+          if (result.is_full()) break;
+          // Waking up after the deadline would only find it expired
+          if (remaining_time() <= delay) {
+            result.fill([&]() -> decltype(auto) {
+              return on_fail(TimeoutError{});
+            });
+            break;
+          }
+          std::this_thread::sleep_for(delay);
+          delay = (std::min)(delay * backoff.factor, backoff.max_delay);
+        }
+        return result.take();
+      }
+
+    private:
+      Backoff backoff;
+      Make make;
+    };
+  }
+
+  // A pre-factory builder that retries with exponential backoff. `make` is
+  // called for a fresh pre-factory builder before every attempt, so it should
+  // return one that owns its arguments (see `Builder::own`). Attempts stop at
+  // the current deadline, which fails with `TimeoutError`, and otherwise after
+  // `backoff.max_attempts`, which fails with the last attempt's error.
+  template <typename Make>
+  inline auto retry(Backoff backoff, Make make) {
+    return detail::RetryBuilder<Make>{backoff, std::move(make)};
+  }
+}}
+
+#endif
@@ -4,20 +4,36 @@
 #include <mz/piecewise/builder.hpp>
 #include <mz/piecewise/forward_tuple.hpp>
 
+#include <type_traits>
+#include <utility>
+
 namespace mz { namespace piecewise {
-  template <typename T>
+  namespace detail {
+    template <typename T>
+    struct BraceConstructor {
+      template <typename ...Args>
+      constexpr T operator()(Args&&... args) const noexcept(noexcept(
+        T{std::forward<Args>(args)...}
+      )) {
+        // Note that we explicitly brace construct
+        return T{std::forward<Args>(args)...};
+      }
+    };
+  }
+
+  // `Construct` makes the `T` from the arguments (see `allocator_wrapper` in
+  // allocator.hpp)
+  template <typename T, typename Construct = detail::BraceConstructor<T>>
   struct Factory {
+    using result_type = T;
+
     template <typename OnSuccess, typename OnFail, typename ...Args>
-    auto operator()(OnSuccess&& on_success, OnFail&&, Args&&... args) const {
-      return on_success(
-        builder(
-          [](auto&&... args) {
-            // Note that we explicitly brace construct
-            return T{std::forward<decltype(args)>(args)...};
-          }
-        , std::forward<Args>(args)...
-        )
-      );
+    constexpr auto operator()(
+      OnSuccess&& on_success, OnFail&&, Args&&... args
+    ) const noexcept(noexcept(
+      on_success(builder(Construct{}, std::forward<Args>(args)...))
+    )) {
+      return on_success(builder(Construct{}, std::forward<Args>(args)...));
     }
   };
 
@@ -25,7 +41,7 @@ namespace mz { namespace piecewise {
   constexpr Factory<T> factory{};
 
   template <typename T, typename ...Args>
-  inline auto wrapper(Args&&... args) {
+  constexpr auto wrapper(Args&&... args) noexcept {
     return builder(factory<T>, std::forward<Args>(args)...);
   }
 }}
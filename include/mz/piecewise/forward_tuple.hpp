@@ -7,33 +7,59 @@
 
 namespace mz { namespace piecewise {
   namespace detail {
+    #if defined(__clang__)
+    #elif defined(__GNUC__) || defined(__GNUG__)
+      #pragma GCC diagnostic push
+      #pragma GCC diagnostic ignored "-Wunused-but-set-parameter"
+    #elif defined(_MSC_VER)
+      #pragma warning( push )
+      #pragma warning( disable : 4100 )
+    #endif
     template <
       typename Callback
     , typename ...Args
     , std::size_t ...Indices
     , typename ...ExtraArgs
-    > inline auto unpack_tuple(
+    > constexpr auto unpack_tuple(
       Callback& callback
-    , std::tuple<Args...> args
+    , std::tuple<Args...>&& args
     , std::index_sequence<Indices...>
     , ExtraArgs&&... extra_args
-    ) {
+    ) noexcept(noexcept(
+      callback(
+        std::forward<ExtraArgs>(extra_args)...
+      , std::forward<Args>(std::get<Indices>(args))...
+      )
+    )) {
       return callback(
         std::forward<ExtraArgs>(extra_args)...
       , std::forward<Args>(std::get<Indices>(args))...
       );
     }
+    #if defined(__clang__)
+    #elif defined(__GNUC__) || defined(__GNUG__)
+      #pragma GCC diagnostic pop
+    #elif defined(_MSC_VER)
+      #pragma warning( pop )
+    #endif
   }
 
   template <
     typename Callback
   , typename ...Args
   , typename ...ExtraArgs
-  > inline auto forward_tuple(
+  > constexpr auto forward_tuple(
     Callback&& callback
   , std::tuple<Args...> args
   , ExtraArgs&&... extra_args
-  ) {
+  ) noexcept(noexcept(
+    detail::unpack_tuple(
+      callback
+    , std::move(args)
+    , std::make_index_sequence<sizeof...(Args)>{}
+    , std::forward<ExtraArgs>(extra_args)...
+    )
+  )) {
     return detail::unpack_tuple(
       callback
     , std::move(args)
@@ -0,0 +1,293 @@
+#ifndef UUID_4064A67D_BEBE_4267_AD1C_2B81221F8D13
+#define UUID_4064A67D_BEBE_4267_AD1C_2B81221F8D13
+
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/in_place.hpp>
+
+#include <memory>
+#include <new>
+#include <utility>
+
+// Construct the object of a post-factory builder directly in the heap
+// allocation that will own it. Since C++17 the object is never moved, so
+// types without copy or move constructors can be held this way too (see
+// in_place.hpp). `PointerHelper` adds `Foo::unique` and friends to a `Helpers`
+// type that also derives from it.
+namespace mz { namespace piecewise {
+  // Destroys an object made by `allocate_unique` and gives its storage back
+  // to the allocator
+  template <typename Allocator>
+  class AllocatorDelete {
+  private:
+    using Traits = std::allocator_traits<Allocator>;
+
+  public:
+    using pointer = typename Traits::pointer;
+
+    explicit AllocatorDelete(Allocator const &allocator_)
+      : allocator(allocator_)
+    {}
+
+    void operator()(pointer object) {
+      std::addressof(*object)->~value_type();
+      Traits::deallocate(allocator, object, 1);
+    }
+
+  private:
+    using value_type = typename Traits::value_type;
+
+    Allocator allocator;
+  };
+
+  namespace detail {
+    // Gives storage back if the constructor throws
+    template <typename Allocator>
+    class Allocation {
+    private:
+      using Traits = std::allocator_traits<Allocator>;
+
+    public:
+      explicit Allocation(Allocator &allocator_)
+        : allocator(allocator_)
+        , pointer{Traits::allocate(allocator, 1)}
+      {}
+      Allocation(Allocation const &) = delete;
+      Allocation &operator=(Allocation const &) = delete;
+
+      ~Allocation() {
+        if (pointer != nullptr) Traits::deallocate(allocator, pointer, 1);
+      }
+
+      void *storage() const noexcept {
+        return static_cast<void *>(std::addressof(*pointer));
+      }
+
+      typename Traits::pointer release() noexcept {
+        auto released = pointer;
+        pointer = nullptr;
+        return released;
+      }
+
+    private:
+      Allocator &allocator;
+      typename Traits::pointer pointer;
+    };
+
+    // Lets `std::allocate_shared` construct the object from a borrowed
+    // builder with `construct_at`, which never moves it on any compiler. The
+    // control block owns a real `T`, so `enable_shared_from_this` works. The
+    // allocator only provides memory, so a polymorphic allocator isn't passed
+    // on to the object.
+    template <typename Allocator, typename Builder>
+    class BuilderAllocator : public Allocator {
+    private:
+      using Traits = std::allocator_traits<Allocator>;
+
+    public:
+      using value_type = typename Traits::value_type;
+
+      template <typename U>
+      struct rebind {
+        using other = BuilderAllocator<
+          typename Traits::template rebind_alloc<U>, Builder
+        >;
+      };
+
+      BuilderAllocator(Allocator const &allocator, Builder &builder_)
+        : Allocator(allocator), builder{&builder_}
+      {}
+
+      template <typename Other>
+      BuilderAllocator(BuilderAllocator<Other, Builder> const &other)
+        : Allocator(static_cast<Other const &>(other))
+        , builder{other.builder}
+      {}
+
+      template <typename U>
+      void construct(U *object) {
+        piecewise::construct_at(object, std::move(*builder));
+      }
+
+      template <typename U>
+      void destroy(U *object) {
+        object->~U();
+      }
+
+    private:
+      template <typename, typename>
+      friend class BuilderAllocator;
+
+      Builder *builder;
+    };
+  }
+
+  template <typename Builder>
+  inline auto make_unique(Builder builder) {
+    using T = typename InPlace<Builder>::result_type;
+    return std::unique_ptr<T>{new T(std::move(builder).construct())};
+  }
+
+  template <typename Allocator, typename Builder>
+  inline auto allocate_unique(Allocator const &allocator, Builder builder) {
+    using T = typename InPlace<Builder>::result_type;
+    using Rebound =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    Rebound rebound(allocator);
+    detail::Allocation<Rebound> allocation{rebound};
+    piecewise::construct_at(allocation.storage(), std::move(builder));
+    return std::unique_ptr<T, AllocatorDelete<Rebound>>{
+      allocation.release(), AllocatorDelete<Rebound>{rebound}
+    };
+  }
+
+  // The object and the control block share one allocation
+  template <typename Allocator, typename Builder>
+  inline auto allocate_shared(Allocator const &allocator, Builder builder) {
+    using T = typename InPlace<Builder>::result_type;
+    return std::allocate_shared<T>(
+      detail::BuilderAllocator<Allocator, Builder>{allocator, builder}
+    );
+  }
+
+  template <typename Builder>
+  inline auto make_shared(Builder builder) {
+    using T = typename InPlace<Builder>::result_type;
+    return std::allocate_shared<T>(
+      detail::BuilderAllocator<std::allocator<T>, Builder>{
+        std::allocator<T>{}, builder
+      }
+    );
+  }
+
+  namespace detail {
+    template <typename T>
+    struct MakeUnique {
+      template <typename Builder>
+      auto operator()(Builder builder) const {
+        return piecewise::make_unique(std::move(builder));
+      }
+
+      auto null() const { return std::unique_ptr<T>{}; }
+    };
+
+    template <typename T>
+    struct MakeShared {
+      template <typename Builder>
+      auto operator()(Builder builder) const {
+        return piecewise::make_shared(std::move(builder));
+      }
+
+      auto null() const { return std::shared_ptr<T>{}; }
+    };
+
+    template <typename T, typename Allocator>
+    struct AllocateUnique {
+      Allocator allocator;
+
+      template <typename Builder>
+      auto operator()(Builder builder) const {
+        return piecewise::allocate_unique(allocator, std::move(builder));
+      }
+
+      auto null() const {
+        using Rebound =
+          typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+        return std::unique_ptr<T, AllocatorDelete<Rebound>>{
+          nullptr, AllocatorDelete<Rebound>{Rebound(allocator)}
+        };
+      }
+    };
+
+    template <typename T, typename Allocator>
+    struct AllocateShared {
+      Allocator allocator;
+
+      template <typename Builder>
+      auto operator()(Builder builder) const {
+        return piecewise::allocate_shared(allocator, std::move(builder));
+      }
+
+      auto null() const { return std::shared_ptr<T>{}; }
+    };
+  }
+
+  // Adds `Foo::unique`, `Foo::shared`, `Foo::allocate_unique` and
+  // `Foo::allocate_shared` to a `Helpers` type that also derives from
+  // `PointerHelper<Helpers<Foo>>`
+  template <typename T>
+  class PointerHelper {
+  public:
+    template <typename Builder, typename Make>
+    class Heap final {
+    private:
+      Builder builder;
+      Make make;
+
+    public:
+      Heap(Builder builder_, Make make_)
+        : builder(std::move(builder_)), make(std::move(make_))
+      {}
+
+      // Returns an empty pointer if the factory fails
+      template <typename ErrorCallback>
+      auto construct(ErrorCallback &&error_callback) && {
+        using Pointer = decltype(make.null());
+        return std::move(builder).construct(
+          [&](auto builder_) -> Pointer {
+            return make(std::move(builder_));
+          }
+        , [&](auto error) {
+            error_callback(error);
+            return make.null();
+          }
+        );
+      }
+    };
+
+    template <typename Builder, typename Make>
+    static auto heap_helper(Builder builder, Make make) {
+      return Heap<Builder, Make>(std::move(builder), std::move(make));
+    }
+
+    template <typename ...Args>
+    static auto unique(Args&&... args) {
+      return heap_helper(
+        BuilderHelper<T>::builder(std::forward<Args>(args)...)
+      , detail::MakeUnique<typename T::Implementation>{}
+      );
+    }
+
+    template <typename ...Args>
+    static auto shared(Args&&... args) {
+      return heap_helper(
+        BuilderHelper<T>::builder(std::forward<Args>(args)...)
+      , detail::MakeShared<typename T::Implementation>{}
+      );
+    }
+
+    // The allocator only provides the memory. To give allocator-aware
+    // members a memory resource, see `with_resource`.
+    template <typename Allocator, typename ...Args>
+    static auto allocate_unique(Allocator const &allocator, Args&&... args) {
+      return heap_helper(
+        BuilderHelper<T>::builder(std::forward<Args>(args)...)
+      , detail::AllocateUnique<typename T::Implementation, Allocator>{
+          allocator
+        }
+      );
+    }
+
+    template <typename Allocator, typename ...Args>
+    static auto allocate_shared(Allocator const &allocator, Args&&... args) {
+      return heap_helper(
+        BuilderHelper<T>::builder(std::forward<Args>(args)...)
+      , detail::AllocateShared<typename T::Implementation, Allocator>{
+          allocator
+        }
+      );
+    }
+  };
+
+}}
+
+#endif
@@ -2,54 +2,254 @@
 #define UUID_C13860C7_1777_4132_9D59_A26F5BB1858A
 
 #include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/in_place.hpp>
 
 #include <type_traits>
 
 #if __cplusplus >= 201703L
+  #include <cstdlib>
   #include <optional>
   #include <variant>
 #endif
 
 namespace mz { namespace piecewise {
+  namespace detail {
+    // Defined in trace.hpp, which types with a tracer must include
+    template <typename Tracer, typename T>
+    struct Trace;
+
+    // An argument the constructor receives after the private tag only if it
+    // takes one there (see `ArenaHelper` in arena.hpp)
+    template <typename T>
+    struct OptionalArgument {
+      T &value;
+    };
+  }
+
+  // Opt-in helpers that live in their own headers, so that types which don't
+  // use them don't pay for their includes. Derive from them next to `Helpers`,
+  // e.g. `public mp::BatchHelper<mp::Helpers<Foo>>` (see batch.hpp).
+  template <typename T>
+  class AllocatorHelper;
+
+  template <typename T>
+  class ArenaHelper;
+
+  template <typename T>
+  class BatchHelper;
+
+  template <typename T>
+  class PointerHelper;
+
+  template <typename T>
+  class ResultHelper;
+
+#if __cplusplus >= 201703L
+  template <typename T>
+  class VariantHelper;
+
+  template <typename T>
+  class OptionalHelper;
+#endif
+
   template <typename T>
   class BuilderHelper {
+  private:
+    // Types that also derive from `AllocatorHelper` receive the current
+    // allocator (see allocator.hpp)
+    template <typename U>
+    using Allocates = std::is_base_of<AllocatorHelper<T>, U>;
+
+    template <typename Make, typename ...Args>
+    static constexpr auto make_instance_as(
+      std::false_type, Make make, Args&&... args
+    ) {
+      return make(typename T::Private{}, std::forward<Args>(args)...);
+    }
+
+    template <typename Make, typename ...Args>
+    static auto make_instance_as(std::true_type, Make make, Args&&... args) {
+      return AllocatorHelper<T>::make_instance(
+        std::move(make), std::forward<Args>(args)...
+      );
+    }
+
+    // Calls `make(tag, args...)`, or lets `AllocatorHelper` add the allocator
+    template <typename Make, typename ...Args>
+    static constexpr auto make_instance(Make make, Args&&... args) {
+      return make_instance_as(
+        Allocates<typename T::Implementation>{}
+      , std::move(make), std::forward<Args>(args)...
+      );
+    }
+
+    struct Constructor {
+      // See `emplace` in in_place.hpp
+      using emplaces_arguments = std::true_type;
+
+      template <
+        typename ...Args
+      , typename U = typename T::Implementation
+      , std::enable_if_t<!Allocates<U>::value, int> = 0
+      > constexpr auto operator()(Args&&... args) const noexcept(noexcept(
+        U(typename T::Private{}, std::forward<Args>(args)...)
+      )) {
+        return U(typename T::Private{}, std::forward<Args>(args)...);
+      }
+
+      template <
+        typename ...Args
+      , typename U = typename T::Implementation
+      , std::enable_if_t<Allocates<U>::value, int> = 0
+      > auto operator()(Args&&... args) const {
+        return make_instance(
+          [](auto&&... args_) {
+            return U(std::forward<decltype(args_)>(args_)...);
+          }
+        , std::forward<Args>(args)...
+        );
+      }
+
+      template <typename Extra, typename ...Args>
+      constexpr auto operator()(
+        detail::OptionalArgument<Extra> extra, Args&&... args
+      ) const {
+        return construct_optional(
+          std::is_constructible<
+            typename T::Implementation, typename T::Private, Extra &, Args...
+          >{}
+        , extra, std::forward<Args>(args)...
+        );
+      }
+
+      // Hands the arguments to the destination instead, which constructs the
+      // object in place
+      template <typename Emplace, typename ...Args>
+      auto operator()(
+        detail::Emplacer<Emplace> emplacer, Args&&... args
+      ) const {
+        return make_instance(emplacer.emplace, std::forward<Args>(args)...);
+      }
+
+    private:
+      template <typename Extra, typename ...Args>
+      constexpr auto construct_optional(
+        std::true_type, detail::OptionalArgument<Extra> extra, Args&&... args
+      ) const {
+        return (*this)(extra.value, std::forward<Args>(args)...);
+      }
+
+      template <typename Extra, typename ...Args>
+      constexpr auto construct_optional(
+        std::false_type, detail::OptionalArgument<Extra>, Args&&... args
+      ) const {
+        return (*this)(std::forward<Args>(args)...);
+      }
+    };
+
+    template <typename Construct>
+    struct FactoryWrapper {
+      // Lets code that only holds the pre-factory builder name the type it
+      // will construct
+      using result_type = typename T::Implementation;
+
+      template <typename ...Args>
+      constexpr auto operator()(Args&&... args) const noexcept(noexcept(
+        T::factory()(Construct{}, std::forward<Args>(args)...)
+      )) {
+        return T::factory()(Construct{}, std::forward<Args>(args)...);
+      }
+    };
+
+    // Reports to `Tracer` (see trace.hpp)
+    template <typename Tracer, typename Construct>
+    struct TracedConstructor {
+      using emplaces_arguments = std::true_type;
+
+      template <typename ...Args>
+      auto operator()(Args&&... args) const {
+        using Trace = detail::Trace<Tracer, typename T::Implementation>;
+        typename Trace::Construction construction;
+        return Construct{}(std::forward<Args>(args)...);
+      }
+    };
+
+    template <typename Tracer, typename Construct>
+    struct TracedFactoryWrapper {
+      using result_type = typename T::Implementation;
+
+      template <typename OnSuccess, typename OnFail, typename ...Args>
+      auto operator()(
+        OnSuccess&& on_success, OnFail&& on_fail, Args&&... args
+      ) const {
+        return detail::Trace<Tracer, result_type>::factory(
+          T::factory()
+        , TracedConstructor<Tracer, Construct>{}
+        , on_success, on_fail
+        , std::forward<Args>(args)...
+        );
+      }
+    };
+
+    // A template so that it is only resolved once `T` is complete. `Construct`
+    // is what the factory receives as its constructor.
+    template <typename U, typename Construct = Constructor>
+    using Wrapper = std::conditional_t<
+      std::is_void<typename U::Tracer>::value
+    , FactoryWrapper<Construct>
+    , TracedFactoryWrapper<typename U::Tracer, Construct>
+    >;
+
+#if __cplusplus >= 201703L
+    // They construct through the same, possibly traced, wrappers
+    friend class VariantHelper<T>;
+    friend class OptionalHelper<T>;
+#endif
+
   public:
     template <typename ...Args>
-    static auto builder(Args&&... args) {
-      auto factory_wrapper = [](auto&&... args_) {
-        auto constructor = [](auto&&... args__) {
-          return typename T::Implementation(
-            typename T::Private{}, std::forward<decltype(args__)>(args__)...
-          );
-        };
-        return T::factory()(
-          constructor, std::forward<decltype(args_)>(args_)...
-        );
-      };
-      return piecewise::builder(factory_wrapper, std::forward<Args>(args)...);
+    static constexpr auto builder(Args&&... args) noexcept(noexcept(
+      piecewise::builder(Wrapper<T>{}, std::forward<Args>(args)...)
+    )) {
+      return piecewise::builder(Wrapper<T>{}, std::forward<Args>(args)...);
+    }
+
+    template <typename ...Args>
+    static auto owning_builder(Args&&... args) {
+      return piecewise::owning_builder(
+        Wrapper<T>{}, std::forward<Args>(args)...
+      );
     }
   };
 
 #if __cplusplus >= 201703L
   template <typename T>
   class VariantHelper {
+  private:
+    template <typename ...ErrorTypes>
+    struct Constructor {
+      template <typename ...Args>
+      constexpr auto operator()(Args&&... args) const {
+        using U = typename T::Implementation;
+        using Variant = std::variant<U, ErrorTypes...>;
+        return BuilderHelper<T>::make_instance(
+          [](auto&&... args_) {
+            return Variant{
+              std::in_place_index<0>, std::forward<decltype(args_)>(args_)...
+            };
+          }
+        , std::forward<Args>(args)...
+        );
+      }
+    };
+
   public:
     template <typename ...ErrorTypes, typename ...Args>
-    static auto variant(Args&&... args) {
-      auto factory_wrapper = [](auto&&... args_) {
-        auto constructor = [](auto&&... args__) {
-          return std::variant<typename T::Implementation, ErrorTypes...>{
-            std::in_place_index<0>
-          , typename T::Private{}
-          , std::forward<decltype(args__)>(args__)...
-          };
-        };
-        return T::factory()(
-          constructor, std::forward<decltype(args_)>(args_)...
-        );
-      };
-      return
-        piecewise::builder(factory_wrapper, std::forward<Args>(args)...)
+    static constexpr auto variant(Args&&... args) {
+      using Wrapper = typename BuilderHelper<T>::template Wrapper<
+        T, Constructor<ErrorTypes...>
+      >;
+      return piecewise::builder(Wrapper{}, std::forward<Args>(args)...)
         .construct(
           [](auto builder) {
             return std::move(builder).construct();
@@ -60,24 +260,39 @@ namespace mz { namespace piecewise {
             };
           }
         );
-      ;
     }
   };
 
   template <typename T>
   class OptionalHelper {
+  private:
+    struct Constructor {
+      template <typename ...Args>
+      constexpr auto operator()(Args&&... args) const {
+        using U = typename T::Implementation;
+        return BuilderHelper<T>::make_instance(
+          [](auto&&... args_) {
+            return std::make_optional<U>(
+              std::forward<decltype(args_)>(args_)...
+            );
+          }
+        , std::forward<Args>(args)...
+        );
+      }
+    };
+
   public:
     template <typename ...Args>
     class Optional final {
     private:
       Builder<Args...> mBuilder;
     public:
-      explicit Optional(Builder<Args...> builder)
+      constexpr explicit Optional(Builder<Args...> builder)
       : mBuilder(std::move(builder))
       {}
 
       template <typename ErrorCallback>
-      auto construct(ErrorCallback &&error_callback) && {
+      constexpr auto construct(ErrorCallback &&error_callback) && {
         return std::move(mBuilder).construct(
           [](auto builder) {
             return std::move(builder).construct();
@@ -91,44 +306,73 @@ namespace mz { namespace piecewise {
     };
 
     template <typename ...Args>
-    static auto optional_helper(Builder<Args...> builder) {
+    static constexpr auto optional_helper(Builder<Args...> builder) {
       return Optional<Args...>(std::move(builder));
     }
 
     template <typename ...Args>
-    static auto optional(Args&&... args) {
-      auto factory_wrapper = [](auto&&... args_) {
-        auto constructor = [](auto&&... args__) {
-          return std::make_optional<typename T::Implementation>(
-            typename T::Private{}, std::forward<decltype(args__)>(args__)...
-          );
-        };
-        return T::factory()(
-          constructor, std::forward<decltype(args_)>(args_)...
-        );
-      };
+    static constexpr auto optional(Args&&... args) {
+      using Wrapper =
+        typename BuilderHelper<T>::template Wrapper<T, Constructor>;
       return optional_helper(
-        piecewise::builder(factory_wrapper, std::forward<Args>(args)...)
+        piecewise::builder(Wrapper{}, std::forward<Args>(args)...)
+      );
+    }
+  };
+
+  namespace detail {
+    // Deliberately not constexpr, so that a factory failing during constant
+    // evaluation is a compile error that names the error
+    template <typename Error>
+    [[noreturn]] inline void constant_construction_failed(Error const &) {
+      std::abort();
+    }
+  }
+
+  template <typename T>
+  class ConstantHelper {
+  public:
+    // Constructs an instance that can initialize a `constexpr` variable. If
+    // the factory fails, compilation fails, or at runtime the program aborts.
+    template <typename ...Args>
+    static constexpr auto constant(Args&&... args) {
+      return BuilderHelper<T>::builder(std::forward<Args>(args)...).construct(
+        [](auto builder) { return std::move(builder).construct(); }
+      , [](auto error) -> typename T::Implementation {
+          detail::constant_construction_failed(error);
+        }
       );
     }
   };
 #endif
 
-  template <typename Derived>
+  // `Tracer`, if given, is told about every factory and constructor run through
+  // `builder` (see trace.hpp)
+  template <typename Derived, typename Tracer_ = void>
   class Helpers
-    : public BuilderHelper<Helpers<Derived>>
+    : public BuilderHelper<Helpers<Derived, Tracer_>>
   #if __cplusplus >= 201703L
-    , public VariantHelper<Helpers<Derived>>
-    , public OptionalHelper<Helpers<Derived>>
+    , public VariantHelper<Helpers<Derived, Tracer_>>
+    , public OptionalHelper<Helpers<Derived, Tracer_>>
+    , public ConstantHelper<Helpers<Derived, Tracer_>>
   #endif
   {
     using Implementation = Derived;
-    static auto factory() { return Derived::factory(); }
+    using Tracer = Tracer_;
+    static constexpr auto factory() noexcept(noexcept(Derived::factory())) {
+      return Derived::factory();
+    }
 
     friend class BuilderHelper<Helpers>;
+    friend class AllocatorHelper<Helpers>;
+    friend class ArenaHelper<Helpers>;
+    friend class PointerHelper<Helpers>;
+    friend class BatchHelper<Helpers>;
+    friend class ResultHelper<Helpers>;
   #if __cplusplus >= 201703L
     friend class VariantHelper<Helpers>;
     friend class OptionalHelper<Helpers>;
+    friend class ConstantHelper<Helpers>;
   #endif
 
   protected:
@@ -0,0 +1,146 @@
+#ifndef UUID_2F6B8D0A_71C3_4E95_A4D8_95E0B3C1F26A
+#define UUID_2F6B8D0A_71C3_4E95_A4D8_95E0B3C1F26A
+
+#include <mz/piecewise/builder.hpp>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 201703L
+  #include <memory>
+  #include <optional>
+  #include <variant>
+#endif
+
+// Whether converting an `InPlace` inside an `emplace`-style function
+// constructs the object directly in the destination (CWG 2327). GCC elides
+// that conversion. Other compilers move the converted object into place, so
+// there the object's type must be movable. `emplace` doesn't depend on this
+// for `Helpers` types.
+#if __cplusplus >= 201703L && defined(__GNUC__) && !defined(__clang__)
+  #define MZ_PIECEWISE_IN_PLACE_CONVERSION
+#endif
+
+namespace mz { namespace piecewise {
+  // Converts to whatever a post-factory builder constructs. Passed to an
+  // `emplace` function, the conversion happens inside the destination, so
+  // with MZ_PIECEWISE_IN_PLACE_CONVERSION the object is constructed directly
+  // in it.
+  template <typename Builder>
+  class InPlace {
+  public:
+    using result_type = decltype(std::declval<Builder>().construct());
+
+    explicit InPlace(Builder& builder_) noexcept : builder{builder_} {}
+
+    operator result_type() && noexcept(noexcept(
+      std::declval<Builder>().construct()
+    )) {
+      return std::move(builder).construct();
+    }
+
+  private:
+    Builder& builder;
+  };
+
+  template <
+    typename Builder
+  , typename = std::enable_if_t<!std::is_lvalue_reference<Builder>::value>
+  > inline InPlace<Builder> in_place(Builder&& builder) noexcept {
+    return InPlace<Builder>{builder};
+  }
+
+  namespace detail {
+    // Passed to the construction callback of a post-factory builder in front
+    // of its arguments. Callbacks that declare `emplaces_arguments`, like the
+    // ones of `Helpers` types, call `emplace` with the arguments of the
+    // constructor instead of calling it themselves, so the destination
+    // constructs the object directly without relying on CWG 2327. Whatever
+    // `emplace` returns is returned by value, so it returns a pointer to the
+    // object rather than a reference.
+    template <typename Emplace>
+    struct Emplacer {
+      Emplace& emplace;
+    };
+
+    template <typename Callback, typename = void>
+    struct EmplacesArguments : std::false_type {};
+
+    template <typename Callback>
+    struct EmplacesArguments<
+      Callback, decltype(void(typename Callback::emplaces_arguments{}))
+    > : std::true_type {};
+
+    template <typename Builder>
+    struct BuilderEmplaces : std::false_type {};
+
+    template <typename Callback, typename ...Forwards>
+    struct BuilderEmplaces<Builder<Callback, Forwards...>>
+      : EmplacesArguments<Callback>
+    {};
+
+    template <typename Builder, typename Emplace>
+    inline auto emplace_with(
+      Emplace& emplace, Builder builder, std::true_type
+    ) {
+      return std::move(builder).construct(Emplacer<Emplace>{emplace});
+    }
+
+    template <typename Builder, typename Emplace>
+    inline auto emplace_with(
+      Emplace& emplace, Builder builder, std::false_type
+    ) {
+      return emplace(in_place(std::move(builder)));
+    }
+
+    // Constructs the object of a post-factory builder by calling `emplace`,
+    // which forwards its arguments to an `emplace`-style function
+    template <typename Builder, typename Emplace>
+    inline auto emplace_with(Emplace&& emplace, Builder builder) {
+      return emplace_with(
+        emplace, std::move(builder), BuilderEmplaces<Builder>{}
+      );
+    }
+  }
+
+  // Constructs the object of a post-factory builder in raw storage, which must
+  // be suitably sized and aligned. Since C++17, this never moves the object,
+  // even if it is nested inside other builders.
+  template <typename Builder>
+  inline auto construct_at(void *storage, Builder builder) noexcept(
+    noexcept(std::declval<Builder>().construct())
+  ) {
+    using T = typename InPlace<Builder>::result_type;
+    return ::new (storage) T(std::move(builder).construct());
+  }
+
+#if __cplusplus >= 201703L
+  template <typename T, typename Builder>
+  inline T &emplace(std::optional<T>& optional, Builder builder) {
+    return *detail::emplace_with(
+      [&](auto&&... args) {
+        return std::addressof(
+          optional.emplace(std::forward<decltype(args)>(args)...)
+        );
+      }
+    , std::move(builder)
+    );
+  }
+
+  template <typename ...Types, typename Builder>
+  inline auto &emplace(std::variant<Types...>& variant, Builder builder) {
+    using T = typename InPlace<Builder>::result_type;
+    return *detail::emplace_with(
+      [&](auto&&... args) {
+        return std::addressof(
+          variant.template emplace<T>(std::forward<decltype(args)>(args)...)
+        );
+      }
+    , std::move(builder)
+    );
+  }
+#endif
+}}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef UUID_2E8D4B17_C6A9_4F53_8D01_97B3E5A4C2F6
+#define UUID_2E8D4B17_C6A9_4F53_8D01_97B3E5A4C2F6
+
+#include <mz/piecewise/builder.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mz { namespace piecewise {
+  namespace detail {
+    template <typename T>
+    class LazyState;
+
+    template <typename T>
+    struct LazyOperations {
+      T (*construct)(LazyState<T> &);
+      void (*discard)(LazyState<T> &) noexcept;
+      void (*release)(LazyState<T> *) noexcept;
+    };
+
+    // The part of a lazy member that doesn't depend on the builder
+    template <typename T>
+    class LazyState {
+    public:
+      explicit LazyState(LazyOperations<T> const &operations_) noexcept
+        : operations(operations_)
+      {}
+      LazyState(LazyState const &) = delete;
+      LazyState &operator=(LazyState const &) = delete;
+
+      // The builder is destroyed as soon as the value exists, so arguments
+      // it owned don't stay resident
+      T &get() {
+        std::call_once(once, [this] {
+          ::new (static_cast<void *>(&storage)) T(operations.construct(*this));
+          constructed.store(true, std::memory_order_release);
+          operations.discard(*this);
+        });
+        return value();
+      }
+
+      bool is_constructed() const noexcept {
+        return constructed.load(std::memory_order_acquire);
+      }
+
+      void release() noexcept { operations.release(this); }
+
+    protected:
+      ~LazyState() {
+        if (is_constructed()) value().~T();
+      }
+
+    private:
+      T &value() noexcept { return *reinterpret_cast<T *>(&storage); }
+
+      LazyOperations<T> const &operations;
+      std::once_flag once;
+      std::atomic<bool> constructed{false};
+      std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    };
+
+    // Holds the owned post-factory builder in the same allocation as the
+    // value
+    template <typename T, typename Builder>
+    class LazyBlock final : public LazyState<T> {
+    public:
+      explicit LazyBlock(Builder builder_) : LazyState<T>{operations} {
+        ::new (static_cast<void *>(&storage)) Builder(std::move(builder_));
+      }
+
+      ~LazyBlock() {
+        if (!this->is_constructed()) builder().~Builder();
+      }
+
+    private:
+      Builder &builder() noexcept {
+        return *reinterpret_cast<Builder *>(&storage);
+      }
+
+      static T construct(LazyState<T> &state) {
+        return std::move(static_cast<LazyBlock &>(state).builder()).construct();
+      }
+
+      static void discard(LazyState<T> &state) noexcept {
+        static_cast<LazyBlock &>(state).builder().~Builder();
+      }
+
+      static void release(LazyState<T> *state) noexcept {
+        delete static_cast<LazyBlock *>(state);
+      }
+
+      static constexpr LazyOperations<T> operations{
+        &construct, &discard, &release
+      };
+
+      std::aligned_storage_t<sizeof(Builder), alignof(Builder)> storage;
+    };
+
+    template <typename T, typename Builder>
+    constexpr LazyOperations<T> LazyBlock<T, Builder>::operations;
+  }
+
+  // A member that is validated eagerly but constructed on first use. It takes
+  // a post-factory builder, so the factory has already succeeded by the time
+  // the aggregate holding it exists. It owns the builder's arguments (see
+  // `Builder::own`) until the first call to `get`, which constructs the value
+  // exactly once even under concurrent first use. Accessing a moved-from
+  // `Lazy` is undefined.
+  template <typename T>
+  class Lazy final {
+  public:
+    template <
+      typename Builder
+    , typename = std::enable_if_t<
+        detail::IsBuilder<std::decay_t<Builder>>::value
+      >
+    > explicit Lazy(Builder&& builder)
+      : state{make_state(
+          std::decay_t<Builder>{std::forward<Builder>(builder)}.own()
+        )}
+    {}
+
+    T &get() { return state->get(); }
+    T const &get() const { return state->get(); }
+
+    T &operator*() { return get(); }
+    T const &operator*() const { return get(); }
+    T *operator->() { return &get(); }
+    T const *operator->() const { return &get(); }
+
+    bool is_constructed() const noexcept { return state->is_constructed(); }
+
+  private:
+    struct Release {
+      void operator()(detail::LazyState<T> *state) const noexcept {
+        state->release();
+      }
+    };
+
+    template <typename Owned>
+    static detail::LazyState<T> *make_state(Owned owned) {
+      return new detail::LazyBlock<T, Owned>(std::move(owned));
+    }
+
+    std::unique_ptr<detail::LazyState<T>, Release> state;
+  };
+
+  // A `Lazy` of whatever the post-factory builder constructs
+  template <typename Builder>
+  inline auto lazy(Builder&& builder) {
+    using T = std::decay_t<
+      decltype(std::declval<std::decay_t<Builder>>().own().construct())
+    >;
+    return Lazy<T>{std::forward<Builder>(builder)};
+  }
+}}
+
+#endif
@@ -1,123 +1,386 @@
 #ifndef UUID_5562D1DE_F4CC_4547_8BC3_0D931B26520D
 #define UUID_5562D1DE_F4CC_4547_8BC3_0D931B26520D
 
-#include <mz/piecewise/forward_tuple.hpp>
-#include <mz/piecewise/tuple_list.hpp>
+#include <mz/piecewise/builder.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace mz { namespace piecewise {
   namespace detail {
+    // Everything a multifail step needs, held by reference. The argument packs
+    // and regular arguments stay where `multifail` received them, so no step
+    // ever moves or re-tuples them.
     template <
       typename Constructor
     , typename OnSuccess, typename OnFail
-    , typename ArgPacks, typename Builders
-    > struct MultifailImpl;
+    , typename ArgPacks, typename RegularArgs
+    > struct MultifailContext {
+      Constructor& constructor;
+      OnSuccess& on_success;
+      OnFail& on_fail;
+      ArgPacks& arg_packs;
+      RegularArgs& regular_args;
+    };
 
     template <
-      typename Constructor
-    , typename OnSuccess, typename OnFail
-    , typename ...ArgPacks, typename ...Builders
-    , typename ...RegularArgs
-    > inline auto multifail_impl(
-        Constructor& constructor
-      , OnSuccess& on_success, OnFail& on_fail
-      , std::tuple<ArgPacks...> arg_packs, std::tuple<Builders...> builders
-      , std::tuple<RegularArgs...> regular_args
-    ) {
-      return MultifailImpl<
-        Constructor
-      , OnSuccess, OnFail
-      , std::tuple<ArgPacks...>
-      , std::tuple<Builders...>
-      >{}(
-        constructor
-      , on_success, on_fail
-      , std::move(arg_packs)
-      , std::move(builders)
-      , std::move(regular_args)
+      typename Context, typename ...RegularArgs
+    , std::size_t ...Indices
+    , typename ...Builders
+    > constexpr auto multifail_finish(
+      Context& context
+    , std::tuple<RegularArgs...>& regular_args
+    , std::index_sequence<Indices...>
+    , Builders&... builders
+    ) noexcept(noexcept(
+      context.on_success(
+        builder(
+          context.constructor
+        , std::forward<RegularArgs>(std::get<Indices>(regular_args))...
+        , std::move(builders)...
+        )
+      )
+    )) {
+      return context.on_success(
+        builder(
+          context.constructor
+        , std::forward<RegularArgs>(std::get<Indices>(regular_args))...
+        , std::move(builders)...
+        )
       );
     }
 
+    template <std::size_t Index, std::size_t Count>
+    struct MultifailImpl;
+
+    // The addresses of the builders built so far, innermost last. Links are
+    // held by value, so restoring the builders only reads fixed offsets.
+    struct MultifailRoot {};
+
+    template <typename Previous, typename Builder>
+    struct MultifailLink {
+      Previous previous;
+      Builder *builder;
+    };
+
+    // The success callback of the step at `Index`. It records where the
+    // post-factory builder lives and moves on to the next step. The context is
+    // copied rather than referenced, which costs a few pointers per step but
+    // saves every step an indirection the optimizer otherwise keeps. Nothing
+    // is cast, so this works in constant expressions too.
     template <
-      typename Constructor
-    , typename OnSuccess, typename OnFail
-    , typename ArgPacks, typename Builders
-    > struct MultifailImpl {
-      template <typename RegularArgs>
-      auto operator()(
-        Constructor& constructor
-      , OnSuccess& on_success, OnFail& on_fail
-      , ArgPacks arg_packs, Builders builders
-      , RegularArgs regular_args
-      ) const {
-        auto split_arg_packs = tuple_list::split(std::move(arg_packs));
-        return std::move(split_arg_packs.head).construct(
-          [ &constructor
-          , &on_success, &on_fail
-          , arg_packs = std::move(split_arg_packs.tail)
-          , builders = std::move(builders)
-          , regular_args = std::move(regular_args)
-          ] (auto builder) mutable {
-            return multifail_impl(
-              constructor
-            , on_success, on_fail
-            , std::move(arg_packs)
-            , tuple_list::combine(std::move(builders), std::move(builder))
-            , std::move(regular_args)
-            );
-          }
-        , on_fail
+      std::size_t Index, std::size_t Count
+    , typename Context, typename Link
+    > struct MultifailContinuation {
+      Context context;
+      Link link;
+
+      template <typename Builder>
+      using Next = MultifailContinuation<
+        Index + 1, Count, Context, MultifailLink<Link, Builder>
+      >;
+
+      template <typename Builder>
+      constexpr auto operator()(Builder builder) const noexcept(noexcept(
+        MultifailImpl<Index + 1, Count>::step(
+          std::declval<Next<Builder> const&>()
+        )
+      )) {
+        Next<Builder> next{context, {link, &builder}};
+        return MultifailImpl<Index + 1, Count>::step(next);
+      }
+    };
+
+    // Up to this many builders, each step first moves its pre-factory builder
+    // out of the argument packs into a local. The optimizer can then see
+    // through the whole graph and fold it when the arguments are known, which
+    // the packs, shared by reference between every step, otherwise prevent.
+    // Wider graphs keep the packs in place, since the extra locals cost them
+    // more than they gain.
+    constexpr std::size_t multifail_local_width = 8;
+
+    template <bool Local>
+    struct MultifailInvoke {
+      template <typename ArgPack, typename Continuation, typename OnFail>
+      static constexpr auto invoke(
+        ArgPack& arg_pack, Continuation const& continuation, OnFail& on_fail
+      ) noexcept(
+        std::is_nothrow_move_constructible<ArgPack>::value
+        && noexcept(std::declval<ArgPack>().construct(continuation, on_fail))
+      ) {
+        auto local = std::move(arg_pack);
+        return std::move(local).construct(continuation, on_fail);
+      }
+    };
+
+    template <>
+    struct MultifailInvoke<false> {
+      template <typename ArgPack, typename Continuation, typename OnFail>
+      static constexpr auto invoke(
+        ArgPack& arg_pack, Continuation const& continuation, OnFail& on_fail
+      ) noexcept(
+        noexcept(std::move(arg_pack).construct(continuation, on_fail))
+      ) {
+        return std::move(arg_pack).construct(continuation, on_fail);
+      }
+    };
+
+    // Invokes the pre-factory builder at `Index`. Post-factory builders live in
+    // the frames of the success callbacks that received them and are only
+    // referred to by address, so each step costs one instantiation and no
+    // moves.
+    template <std::size_t Index, std::size_t Count>
+    struct MultifailImpl {
+      using Invoke = MultifailInvoke<(Count <= multifail_local_width)>;
+
+      template <typename Continuation>
+      static constexpr auto step(Continuation const& continuation) noexcept(
+        noexcept(
+          Invoke::invoke(
+            std::get<Index>(continuation.context.arg_packs)
+          , continuation, continuation.context.on_fail
+          )
+        )
+      ) {
+        return Invoke::invoke(
+          std::get<Index>(continuation.context.arg_packs)
+        , continuation, continuation.context.on_fail
         );
       }
     };
 
-    template <
-      typename Constructor
-    , typename OnSuccess, typename OnFail
-    , typename Builders
-    > struct MultifailImpl<
-        Constructor
-      , OnSuccess, OnFail
-      , std::tuple<>
-      , Builders
-      > {
-      template <typename RegularArgs>
-      auto operator()(
-        Constructor& constructor
-      , OnSuccess& on_success, OnFail&
-      , std::tuple<>, Builders packed_builders
-      , RegularArgs regular_args
-      ) const {
-        return forward_tuple(
-          [ &constructor
-          , &on_success
-          , packed_builders = std::move(packed_builders)
-          ] (auto&&... regular_args_) mutable {
-            return forward_tuple(
-              [&constructor, &on_success](auto&&... args) {
-                return on_success(
-                  builder(
-                    constructor
-                  , std::forward<decltype(args)>(args)...
-                  )
-                );
-              }
-            , std::move(packed_builders)
-            , std::forward<decltype(regular_args_)>(regular_args_)...
-            );
+    template <std::size_t Count>
+    struct MultifailImpl<Count, Count> {
+      template <typename Continuation>
+      static constexpr auto step(Continuation const& continuation) noexcept(
+        noexcept(restore(continuation.context, continuation.link))
+      ) {
+        return restore(continuation.context, continuation.link);
+      }
+
+      template <typename Context, typename ...Builders>
+      static constexpr auto finish(
+        Context& context, Builders&... builders
+      ) noexcept(
+        noexcept(
+          multifail_finish(
+            context
+          , context.regular_args
+          , std::make_index_sequence<
+              std::tuple_size<
+                std::remove_reference_t<decltype(context.regular_args)>
+              >::value
+            >{}
+          , builders...
+          )
+        )
+      ) {
+        return multifail_finish(
+          context
+        , context.regular_args
+        , std::make_index_sequence<
+            std::tuple_size<
+              std::remove_reference_t<decltype(context.regular_args)>
+            >::value
+          >{}
+        , builders...
+        );
+      }
+
+    private:
+      // Unwinds the links back into a pack, first builder first
+      template <typename Context, typename ...Builders>
+      static constexpr auto restore(
+        Context& context, MultifailRoot, Builders&... builders
+      ) noexcept(noexcept(finish(context, builders...))) {
+        return finish(context, builders...);
+      }
+
+      template <
+        typename Context, typename Previous, typename Builder
+      , typename ...Builders
+      > static constexpr auto restore(
+        Context& context
+      , MultifailLink<Previous, Builder> const& link
+      , Builders&... builders
+      ) noexcept(noexcept(
+        restore(context, link.previous, *link.builder, builders...)
+      )) {
+        return restore(context, link.previous, *link.builder, builders...);
+      }
+    };
+  }
+
+  namespace detail {
+    template <typename Callback, typename = void>
+    struct CostedResult {};
+
+    template <typename Callback>
+    struct CostedResult<Callback, decltype(void(
+      std::declval<typename Callback::result_type *>()
+    ))> {
+      using result_type = typename Callback::result_type;
+    };
+
+    // The factory of a builder made by `cost`. `Callback` is that of the
+    // builder it wraps, if any, so the constructed type stays visible.
+    template <int Cost, typename Callback>
+    struct CostedFactory : CostedResult<Callback> {
+      template <typename OnSuccess, typename OnFail, typename Wrapped>
+      constexpr auto operator()(
+        OnSuccess&& on_success, OnFail&& on_fail, Wrapped&& wrapped
+      ) const noexcept(noexcept(
+        std::forward<Wrapped>(wrapped).construct(
+          std::forward<OnSuccess>(on_success), std::forward<OnFail>(on_fail)
+        )
+      )) {
+        return std::forward<Wrapped>(wrapped).construct(
+          std::forward<OnSuccess>(on_success), std::forward<OnFail>(on_fail)
+        );
+      }
+    };
+
+    template <typename T>
+    struct CallbackOf {
+      using type = void;
+    };
+
+    template <typename Callback, typename ...Forwards>
+    struct CallbackOf<Builder<Callback, Forwards...>> {
+      using type = Callback;
+    };
+
+    template <typename T>
+    struct BuilderCost : std::integral_constant<int, 0> {};
+
+    template <int Cost, typename Callback, typename ...Forwards>
+    struct BuilderCost<Builder<CostedFactory<Cost, Callback>, Forwards...>>
+      : std::integral_constant<int, Cost>
+    {};
+
+    // Cheapest first, and in declared order among equal costs
+    template <int ...Costs>
+    struct CostOrder {
+      // Where the builder declared at `index` runs
+      static constexpr std::size_t position(std::size_t index) {
+        constexpr int costs[] = {0, Costs...};
+        std::size_t result = 0;
+        for (std::size_t other = 0; other < sizeof...(Costs); ++other) {
+          if (
+            costs[other + 1] < costs[index + 1]
+            || (costs[other + 1] == costs[index + 1] && other < index)
+          ) {
+            ++result;
           }
-        , std::move(regular_args)
+        }
+        return result;
+      }
+
+      // The declared index of the builder that runs at `position_`
+      static constexpr std::size_t declared(std::size_t position_) {
+        for (std::size_t index = 0; index < sizeof...(Costs); ++index) {
+          if (position(index) == position_) return index;
+        }
+        return 0;
+      }
+
+      static constexpr bool is_declared_order() {
+        for (std::size_t index = 0; index < sizeof...(Costs); ++index) {
+          if (position(index) != index) return false;
+        }
+        return true;
+      }
+    };
+
+    template <typename ...ArgPacks>
+    using MultifailOrder = CostOrder<
+      BuilderCost<std::decay_t<ArgPacks>>::value...
+    >;
+
+    // Receives the post-factory builders in the order their factories ran,
+    // and passes them on in declared order after the regular arguments. It
+    // holds a copy of the constructor, as the post-factory builder it ends up
+    // in would, so that an owned builder (see `Builder::own`) can outlive the
+    // factory.
+    template <typename Constructor, typename Order, std::size_t RegularCount>
+    struct DeclaredOrderConstructor {
+      Constructor constructor;
+
+      template <
+        typename Args, std::size_t ...Regular, std::size_t ...Declared
+      > constexpr auto call(
+        Args args
+      , std::index_sequence<Regular...>, std::index_sequence<Declared...>
+      ) const noexcept(noexcept(
+        constructor(
+          std::get<Regular>(std::move(args))...
+        , std::get<RegularCount + Order::position(Declared)>(
+            std::move(args)
+          )...
+        )
+      )) {
+        return constructor(
+          std::get<Regular>(std::move(args))...
+        , std::get<RegularCount + Order::position(Declared)>(
+            std::move(args)
+          )...
+        );
+      }
+
+      template <typename ...Args>
+      constexpr auto operator()(Args&&... args) const noexcept(noexcept(
+        std::declval<DeclaredOrderConstructor const&>().call(
+          std::forward_as_tuple(std::forward<Args>(args)...)
+        , std::make_index_sequence<RegularCount>{}
+        , std::make_index_sequence<sizeof...(Args) - RegularCount>{}
+        )
+      )) {
+        return call(
+          std::forward_as_tuple(std::forward<Args>(args)...)
+        , std::make_index_sequence<RegularCount>{}
+        , std::make_index_sequence<sizeof...(Args) - RegularCount>{}
         );
       }
     };
+
+    template <typename Order, typename ArgPacks, std::size_t ...Positions>
+    constexpr auto run_order(
+      ArgPacks& arg_packs, std::index_sequence<Positions...>
+    ) noexcept(
+      std::is_nothrow_move_constructible<ArgPacks>::value
+    ) {
+      return std::tuple<
+        std::tuple_element_t<Order::declared(Positions), ArgPacks>...
+      >{std::move(std::get<Order::declared(Positions)>(arg_packs))...};
+    }
+  }
+
+  // Tags a nested pre-factory builder with the cost of its factory. Within
+  // one `multifail`, factories run cheapest first, and untagged builders
+  // cost 0, so tag expensive factories with a positive cost and cheap checks
+  // that are likely to fail with a negative one. The constructor still
+  // receives the post-factory builders in declared order.
+  template <int Cost, typename Wrapped>
+  constexpr auto cost(Wrapped wrapped) noexcept(
+    std::is_nothrow_move_constructible<Wrapped>::value
+  ) {
+    return make_builder(
+      detail::CostedFactory<Cost, typename detail::CallbackOf<Wrapped>::type>{}
+    , std::tuple<Wrapped>{std::move(wrapped)}
+    );
   }
 
   template <typename ...Builders>
-  inline auto builders(Builders... builders) {
-    return std::make_tuple(std::move(builders)...);
+  constexpr auto builders(Builders... builders) noexcept(
+    std::is_nothrow_move_constructible<std::tuple<Builders...>>::value
+  ) {
+    return std::tuple<Builders...>{std::move(builders)...};
   }
 
   template <typename ...Args>
-  inline auto arguments(Args&&... args) {
+  constexpr auto arguments(Args&&... args) noexcept {
     return std::forward_as_tuple(std::forward<Args>(args)...);
   }
 
@@ -126,17 +389,85 @@ namespace mz { namespace piecewise {
   , typename OnSuccess, typename OnFail
   , typename ...ArgPacks
   , typename ...RegularArgs
-  > inline auto multifail(
+  , std::enable_if_t<
+      detail::MultifailOrder<ArgPacks...>::is_declared_order(), int
+    > = 0
+  > constexpr auto multifail(
     Constructor&& constructor
   , OnSuccess&& on_success, OnFail&& on_fail
   , std::tuple<ArgPacks...> arg_packs
   , std::tuple<RegularArgs...> regular_args = std::tuple<>{}
-  ) {
-    return detail::multifail_impl(
+  ) noexcept(noexcept(
+    detail::MultifailImpl<0, sizeof...(ArgPacks)>::step(
+      std::declval<
+        detail::MultifailContinuation<
+          0, sizeof...(ArgPacks)
+        , detail::MultifailContext<
+            std::remove_reference_t<Constructor>
+          , std::remove_reference_t<OnSuccess>, std::remove_reference_t<OnFail>
+          , std::tuple<ArgPacks...>, std::tuple<RegularArgs...>
+          >
+        , detail::MultifailRoot
+        > const&
+      >()
+    )
+  )) {
+    using Context = detail::MultifailContext<
+      std::remove_reference_t<Constructor>
+    , std::remove_reference_t<OnSuccess>, std::remove_reference_t<OnFail>
+    , std::tuple<ArgPacks...>, std::tuple<RegularArgs...>
+    >;
+    Context context{
       constructor
     , on_success, on_fail
-    , std::move(arg_packs)
-    , std::tuple<>{}
+    , arg_packs
+    , regular_args
+    };
+    detail::MultifailContinuation<
+      0, sizeof...(ArgPacks), Context, detail::MultifailRoot
+    > start{context, {}};
+    return detail::MultifailImpl<0, sizeof...(ArgPacks)>::step(start);
+  }
+
+  // Some builders are tagged with `cost` and aren't in cost order yet
+  template <
+    typename Constructor
+  , typename OnSuccess, typename OnFail
+  , typename ...ArgPacks
+  , typename ...RegularArgs
+  , std::enable_if_t<
+      !detail::MultifailOrder<ArgPacks...>::is_declared_order(), int
+    > = 0
+  > constexpr auto multifail(
+    Constructor&& constructor
+  , OnSuccess&& on_success, OnFail&& on_fail
+  , std::tuple<ArgPacks...> arg_packs
+  , std::tuple<RegularArgs...> regular_args = std::tuple<>{}
+  ) noexcept(noexcept(
+    multifail(
+      std::declval<
+        detail::DeclaredOrderConstructor<
+          std::decay_t<Constructor>
+        , detail::MultifailOrder<ArgPacks...>, sizeof...(RegularArgs)
+        >&
+      >()
+    , on_success, on_fail
+    , detail::run_order<detail::MultifailOrder<ArgPacks...>>(
+        arg_packs, std::index_sequence_for<ArgPacks...>{}
+      )
+    , std::move(regular_args)
+    )
+  )) {
+    using Order = detail::MultifailOrder<ArgPacks...>;
+    detail::DeclaredOrderConstructor<
+      std::decay_t<Constructor>, Order, sizeof...(RegularArgs)
+    > declared_order{constructor};
+    return multifail(
+      declared_order
+    , on_success, on_fail
+    , detail::run_order<Order>(
+        arg_packs, std::index_sequence_for<ArgPacks...>{}
+      )
     , std::move(regular_args)
     );
   }
@@ -0,0 +1,124 @@
+#ifndef UUID_E83B1D46_0F7C_4A59_8D2E_6C94A1B07F35
+#define UUID_E83B1D46_0F7C_4A59_8D2E_6C94A1B07F35
+
+#include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/task.hpp>
+
+#if defined(MZ_PIECEWISE_COROUTINES)
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace mz { namespace piecewise {
+  namespace detail {
+    // Every step suspends while the factory at `Index` runs. Builders are
+    // converted to owning builders first, so nothing refers to the frame of a
+    // factory that returned a task before it finished.
+    template <std::size_t Index, std::size_t Count>
+    struct AsyncMultifailImpl {
+      template <typename Context, typename ...Builders>
+      static Task<> step(Context& context, Builders&... builders) {
+        co_await std::move(std::get<Index>(context.arg_packs)).construct(
+          [&context, &builders...](auto builder) {
+            return resume(context, std::move(builder).own(), builders...);
+          }
+        , context.on_fail
+        );
+      }
+
+      // Holds the owning builder in its frame until the remaining steps finish
+      template <typename Context, typename Builder, typename ...Builders>
+      static Task<> resume(
+        Context& context, Builder builder, Builders&... builders
+      ) {
+        co_await AsyncMultifailImpl<Index + 1, Count>::step(
+          context, builders..., builder
+        );
+      }
+    };
+
+    template <std::size_t Count>
+    struct AsyncMultifailImpl<Count, Count> {
+      template <typename Context, typename ...Builders>
+      static Task<> step(Context& context, Builders&... builders) {
+        return MultifailImpl<Count, Count>::finish(context, builders...);
+      }
+    };
+
+    template <
+      typename Constructor
+    , typename OnSuccess, typename OnFail
+    , typename ...ArgPacks
+    , typename ...RegularArgs
+    > Task<> run_multifail_async(
+      Constructor constructor
+    , OnSuccess& on_success, OnFail& on_fail
+    , std::tuple<ArgPacks...> arg_packs
+    , std::tuple<RegularArgs...> regular_args
+    ) {
+      MultifailContext<
+        Constructor
+      , OnSuccess, OnFail
+      , std::tuple<ArgPacks...>, std::tuple<RegularArgs...>
+      > context{
+        constructor
+      , on_success, on_fail
+      , arg_packs
+      , regular_args
+      };
+      co_await AsyncMultifailImpl<0, sizeof...(ArgPacks)>::step(context);
+    }
+
+    template <
+      typename Constructor
+    , typename OnSuccess, typename OnFail
+    , typename ...ArgPacks
+    , typename ...RegularArgs
+    , std::size_t ...Indices
+    > Task<> own_multifail_async(
+      Constructor constructor
+    , OnSuccess& on_success, OnFail& on_fail
+    , std::tuple<ArgPacks...> arg_packs
+    , std::tuple<RegularArgs...> regular_args
+    , std::index_sequence<Indices...>
+    ) {
+      return run_multifail_async(
+        std::move(constructor)
+      , on_success, on_fail
+      , std::make_tuple(std::move(std::get<Indices>(arg_packs)).own()...)
+      , std::tuple<std::decay_t<RegularArgs>...>{std::move(regular_args)}
+      );
+    }
+  }
+
+  // The asynchronous counterpart of `multifail`, for factories used with
+  // `construct_async`. The nested factories run one after another, and each
+  // one may suspend. Builders and regular arguments are moved or copied into
+  // the returned task (see `Builder::own`), so a factory may return it
+  // without awaiting it. The callbacks must outlive the task.
+  template <
+    typename Constructor
+  , typename OnSuccess, typename OnFail
+  , typename ...ArgPacks
+  , typename ...RegularArgs
+  > inline Task<> multifail_async(
+    Constructor constructor
+  , OnSuccess& on_success, OnFail& on_fail
+  , std::tuple<ArgPacks...> arg_packs
+  , std::tuple<RegularArgs...> regular_args = std::tuple<>{}
+  ) {
+    return detail::own_multifail_async(
+      std::move(constructor)
+    , on_success, on_fail
+    , std::move(arg_packs)
+    , std::move(regular_args)
+    , std::index_sequence_for<ArgPacks...>{}
+    );
+  }
+}}
+
+#endif
+
+#endif
@@ -0,0 +1,450 @@
+#ifndef UUID_E3B5D0A8_2F6C_4C1E_8A7B_94D1F6E2C5B0
+#define UUID_E3B5D0A8_2F6C_4C1E_8A7B_94D1F6E2C5B0
+
+#include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/slot.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mz { namespace piecewise {
+  // The post-factory builder that `parallel_multifail` passes to the
+  // constructor. The real builder still references its factory's arguments, so
+  // it stays parked on the thread that ran the factory until construction is
+  // over.
+  template <typename T>
+  class ParallelBuilder {
+  public:
+    ParallelBuilder(void *builder_, T (*construct_callback_)(void *))
+      : builder{builder_}, construct_callback{construct_callback_}
+    {}
+
+    T construct() && { return construct_callback(builder); }
+
+  private:
+    void *builder;
+    T (*construct_callback)(void *);
+  };
+
+  // The simplest executor: every task gets its own thread, and all threads are
+  // joined when the executor is destroyed.
+  class ThreadExecutor {
+  public:
+    ThreadExecutor() = default;
+    ThreadExecutor(ThreadExecutor const &) = delete;
+    ThreadExecutor &operator=(ThreadExecutor const &) = delete;
+    ~ThreadExecutor() { join(); }
+
+    template <typename Task>
+    void operator()(Task task) { threads.emplace_back(std::move(task)); }
+
+    void join() {
+      for (auto &thread : threads) thread.join();
+      threads.clear();
+    }
+
+  private:
+    std::vector<std::thread> threads;
+  };
+
+  namespace detail {
+    // The type a pre-factory builder eventually constructs.
+    // `parallel_multifail` needs it up front because post-factory builder
+    // types are only visible inside the success callbacks, which run on other
+    // threads.
+    template <typename Builder>
+    struct BuilderResult;
+
+    template <typename ConstructCallback, typename ...Forwards>
+    struct BuilderResult<Builder<ConstructCallback, Forwards...>> {
+      using type = typename ConstructCallback::result_type;
+    };
+
+    template <typename Builder>
+    using builder_result_t = typename BuilderResult<Builder>::type;
+
+    // Synchronization state shared with the executor's tasks. It is reference
+    // counted so that a task the executor runs after `parallel_multifail` has
+    // returned only finds that there is nothing left to claim.
+    class ParallelShared {
+    public:
+      enum class Claim { none, skip, run };
+
+      ParallelShared(
+        std::size_t count_
+      , void *context_
+      , void (*run_)(void *, std::size_t, bool)
+      , void (*owner_loop_)(void *)
+      ) : count{count_}
+        , context{context_}
+        , run{run_}
+        , owner_loop{owner_loop_}
+        , owner{std::this_thread::get_id()}
+      {}
+
+      // Entry point for executor tasks
+      void work() {
+        if (std::this_thread::get_id() == owner) {
+          // The executor ran the task inline, so the owner has to drive the
+          // whole construction from here
+          {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (closed) return;
+          }
+          owner_loop(context);
+          return;
+        }
+
+        std::size_t index;
+        if (claim(index, false) != Claim::run) return;
+        run(context, index, false);
+        {
+          std::lock_guard<std::mutex> lock{mutex};
+          --in_flight;
+        }
+        condition.notify_all();
+      }
+
+      // Jobs claimed after a failure are skipped, which is how the remaining
+      // factories get cancelled
+      Claim claim(std::size_t &index, bool on_owner) {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (closed || next == count) return Claim::none;
+        index = next++;
+        if (failed) return Claim::skip;
+        if (!on_owner) ++in_flight;
+        return Claim::run;
+      }
+
+      template <typename Publish>
+      void succeed(Publish&& publish) {
+        {
+          std::lock_guard<std::mutex> lock{mutex};
+          publish();
+          ++succeeded;
+        }
+        condition.notify_all();
+      }
+
+      // Only the first failure is published
+      template <typename Publish>
+      void fail(Publish&& publish) {
+        {
+          std::lock_guard<std::mutex> lock{mutex};
+          if (failed) return;
+          failed = true;
+          publish();
+        }
+        condition.notify_all();
+      }
+
+      // Blocks until every factory succeeded or one failed, then stops further
+      // claims. Returns whether a factory failed.
+      bool settle() {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition.wait(lock, [this] { return failed || succeeded == count; });
+        closed = true;
+        return failed;
+      }
+
+      void wait_released() {
+        std::unique_lock<std::mutex> lock{mutex};
+        condition.wait(lock, [this] { return released; });
+      }
+
+      // Stops further claims, unparks every worker and waits for their
+      // factories to return. Safe to call more than once.
+      void release() {
+        std::unique_lock<std::mutex> lock{mutex};
+        closed = true;
+        released = true;
+        condition.notify_all();
+        condition.wait(lock, [this] { return in_flight == 0; });
+      }
+
+    private:
+      std::mutex mutex;
+      std::condition_variable condition;
+      std::size_t const count;
+      std::size_t next = 0;
+      std::size_t in_flight = 0;
+      std::size_t succeeded = 0;
+      bool failed = false;
+      bool closed = false;
+      bool released = false;
+      void *const context;
+      void (*const run)(void *, std::size_t, bool);
+      void (*const owner_loop)(void *);
+      std::thread::id const owner;
+    };
+
+    struct ParallelTask {
+      std::shared_ptr<ParallelShared> shared;
+
+      void operator()() const { shared->work(); }
+    };
+
+    template <typename T>
+    struct ParallelReady {
+      void *builder = nullptr;
+      T (*construct_callback)(void *) = nullptr;
+    };
+
+    template <typename T, typename Builder>
+    T parallel_construct(void *builder) {
+      return std::move(*static_cast<Builder *>(builder)).construct();
+    }
+
+    template <
+      typename Constructor, typename OnSuccess
+    , typename RegularArgs, typename ...Results
+    > struct ParallelResult;
+
+    template <
+      typename Constructor, typename OnSuccess
+    , typename ...RegularArgs, typename ...Results
+    > struct ParallelResult<
+        Constructor, OnSuccess
+      , std::tuple<RegularArgs...>, Results...
+      > {
+      using type = decltype(
+        std::declval<OnSuccess&>()(
+          builder(
+            std::declval<Constructor&>()
+          , std::declval<RegularArgs>()...
+          , std::declval<ParallelBuilder<Results>>()...
+          )
+        )
+      );
+    };
+
+    template <
+      typename Result
+    , typename Constructor
+    , typename OnSuccess, typename OnFail
+    , typename ArgPacks, typename RegularArgs
+    , typename Indices
+    > class ParallelContext;
+
+    template <
+      typename Result
+    , typename Constructor
+    , typename OnSuccess, typename OnFail
+    , typename ...ArgPacks, typename ...RegularArgs
+    , std::size_t ...Indices
+    > class ParallelContext<
+        Result
+      , Constructor
+      , OnSuccess, OnFail
+      , std::tuple<ArgPacks...>, std::tuple<RegularArgs...>
+      , std::index_sequence<Indices...>
+      > {
+    public:
+      ParallelContext(
+        Constructor& constructor_
+      , OnSuccess& on_success_, OnFail& on_fail_
+      , std::tuple<ArgPacks...>& arg_packs_
+      , std::tuple<RegularArgs...>& regular_args_
+      ) : constructor(constructor_)
+        , on_success(on_success_), on_fail(on_fail_)
+        , arg_packs(arg_packs_)
+        , regular_args(regular_args_)
+        , shared{
+            std::make_shared<ParallelShared>(
+              sizeof...(ArgPacks), this, &run_erased, &owner_loop_erased
+            )
+          }
+      {}
+
+      ParallelContext(ParallelContext const &) = delete;
+      ParallelContext &operator=(ParallelContext const &) = delete;
+
+      // If a factory, the constructor or a callback threw on the calling
+      // thread, workers may still be parked on frames that reference this
+      // context, so they are released before it goes away
+      ~ParallelContext() { shared->release(); }
+
+      ParallelTask task() const { return {shared}; }
+
+      // Runs on the calling thread. Claims jobs the executor hasn't started
+      // yet, which also keeps small pools from deadlocking on parked workers.
+      void owner_loop() {
+        std::size_t index;
+        for (;;) {
+          switch (shared->claim(index, true)) {
+          case ParallelShared::Claim::none:
+            finish();
+            return;
+          case ParallelShared::Claim::skip:
+            continue;
+          case ParallelShared::Claim::run:
+            // Construction finishes inside this job's callbacks
+            run(index, true);
+            return;
+          }
+        }
+      }
+
+      Result take() { return result.take(); }
+
+    private:
+      using Jobs = std::tuple<ParallelReady<builder_result_t<ArgPacks>>...>;
+
+      static void run_erased(void *self, std::size_t index, bool on_owner) {
+        static_cast<ParallelContext *>(self)->run(index, on_owner);
+      }
+
+      static void owner_loop_erased(void *self) {
+        static_cast<ParallelContext *>(self)->owner_loop();
+      }
+
+      void run(std::size_t index, bool on_owner) {
+        using Job = void (ParallelContext::*)(bool);
+        // The leading null entry keeps the array valid without builders
+        Job const jobs[] = {nullptr, &ParallelContext::run_job<Indices>...};
+        (this->*jobs[index + 1])(on_owner);
+      }
+
+      template <std::size_t Index>
+      void run_job(bool on_owner) {
+        using T = builder_result_t<
+          std::tuple_element_t<Index, std::tuple<ArgPacks...>>
+        >;
+        std::move(std::get<Index>(arg_packs)).construct(
+          [this, on_owner](auto builder) {
+            using Builder = decltype(builder);
+            static_assert(
+              std::is_same<decltype(std::move(builder).construct()), T>::value
+            , "A builder's result_type must match what its post-factory "
+              "builder constructs"
+            );
+            shared->succeed([&] {
+              std::get<Index>(jobs).builder = &builder;
+              std::get<Index>(jobs).construct_callback =
+                &parallel_construct<T, Builder>;
+            });
+            park(on_owner);
+          }
+        , [this, on_owner](auto error) {
+            shared->fail([&] {
+              failure = &error;
+              fail_callback = &fail_erased<decltype(error)>;
+            });
+            park(on_owner);
+          }
+        );
+      }
+
+      // Keeps a factory's frame, and therefore its post-factory builder or
+      // error, alive until construction is over
+      void park(bool on_owner) {
+        if (on_owner) owner_loop();
+        else shared->wait_released();
+      }
+
+      template <typename Error>
+      static void fail_erased(void *error, ParallelContext &self) {
+        self.result.fill([&]() -> Result {
+          return self.on_fail(std::move(*static_cast<Error *>(error)));
+        });
+      }
+
+      template <typename T>
+      static ParallelBuilder<T> parallel_builder(
+        ParallelReady<T> const &ready
+      ) {
+        return {ready.builder, ready.construct_callback};
+      }
+
+      template <std::size_t ...RegularIndices>
+      Result construct_result(std::index_sequence<RegularIndices...>) {
+        return on_success(
+          builder(
+            constructor
+          , std::forward<RegularArgs>(std::get<RegularIndices>(regular_args))...
+          , parallel_builder(std::get<Indices>(jobs))...
+          )
+        );
+      }
+
+      void finish() {
+        // A task that ran inline on the owner thread may have finished already
+        if (result.is_full()) return;
+        if (shared->settle()) {
+          fail_callback(failure, *this);
+        } else {
+          result.fill([this] {
+            return construct_result(std::index_sequence_for<RegularArgs...>{});
+          });
+        }
+        shared->release();
+      }
+
+      Constructor& constructor;
+      OnSuccess& on_success;
+      OnFail& on_fail;
+      std::tuple<ArgPacks...>& arg_packs;
+      std::tuple<RegularArgs...>& regular_args;
+      std::shared_ptr<ParallelShared> shared;
+      Jobs jobs;
+      void *failure = nullptr;
+      void (*fail_callback)(void *, ParallelContext &) = nullptr;
+      Slot<Result> result;
+    };
+  }
+
+  // Like `multifail`, but runs the factories of the given builders
+  // concurrently on `executor`, which is any callable that accepts a nullary
+  // task and eventually invokes it once. The constructor and exactly one of
+  // `on_success` and `on_fail` run on the calling thread. Each builder's
+  // callback must expose the constructed type as `result_type`, which is the
+  // case for `Helpers` types and `wrapper`.
+  template <
+    typename Executor
+  , typename Constructor
+  , typename OnSuccess, typename OnFail
+  , typename ...ArgPacks
+  , typename ...RegularArgs
+  > inline auto parallel_multifail(
+    Executor&& executor
+  , Constructor&& constructor
+  , OnSuccess&& on_success, OnFail&& on_fail
+  , std::tuple<ArgPacks...> arg_packs
+  , std::tuple<RegularArgs...> regular_args = std::tuple<>{}
+  ) {
+    using Result = typename detail::ParallelResult<
+      std::remove_reference_t<Constructor>
+    , std::remove_reference_t<OnSuccess>
+    , std::tuple<RegularArgs...>
+    , detail::builder_result_t<ArgPacks>...
+    >::type;
+    detail::ParallelContext<
+      Result
+    , std::remove_reference_t<Constructor>
+    , std::remove_reference_t<OnSuccess>, std::remove_reference_t<OnFail>
+    , std::tuple<ArgPacks...>, std::tuple<RegularArgs...>
+    , std::index_sequence_for<ArgPacks...>
+    > context{
+      constructor
+    , on_success, on_fail
+    , arg_packs
+    , regular_args
+    };
+    // The calling thread always takes part, so one task fewer is enough
+    for (std::size_t i = 1; i < sizeof...(ArgPacks); ++i) {
+      executor(context.task());
+    }
+    context.owner_loop();
+    return context.take();
+  }
+}}
+
+#endif
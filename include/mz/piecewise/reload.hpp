@@ -0,0 +1,153 @@
+#ifndef UUID_FA7AFA46_3E2D_48C6_93FB_A1E90E481AD5
+#define UUID_FA7AFA46_3E2D_48C6_93FB_A1E90E481AD5
+
+#include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/heap.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+namespace mz { namespace piecewise {
+  // The current version of one member of a reloadable aggregate, and the
+  // arguments it was constructed from. Its builders construct a
+  // `std::shared_ptr<T const>`, so versions of the aggregate that were built
+  // from the same arguments share the member.
+  template <typename T, typename ...Args>
+  class Reusable {
+  public:
+    Reusable() = default;
+    Reusable(Reusable const &) = delete;
+    Reusable &operator=(Reusable const &) = delete;
+
+    // A nested pre-factory builder. If the arguments compare equal to the
+    // ones the current version was constructed from, it constructs that
+    // version again without running the factory of `T`. Otherwise it
+    // forwards to `T::builder(args...)`, and the new version replaces the
+    // current one when it is constructed.
+    template <typename ...Forwards>
+    auto builder(Forwards&&... args) {
+      return piecewise::builder(
+        ReusableFactory{*this}, std::forward<Forwards>(args)...
+      );
+    }
+
+    // The current version, or null before the first construction
+    std::shared_ptr<T const> const &get() const noexcept { return current; }
+
+  private:
+    struct ReusableFactory {
+      using result_type = std::shared_ptr<T const>;
+
+      Reusable &reusable;
+
+      template <typename OnSuccess, typename OnFail, typename ...Forwards>
+      auto operator()(
+        OnSuccess&& on_success, OnFail&& on_fail, Forwards&&... args
+      ) const {
+        if (reusable.is_unchanged(args...)) {
+          return on_success(
+            piecewise::builder(
+              [](Reusable &reusable_) { return reusable_.current; }
+            , reusable
+            )
+          );
+        }
+        return T::builder(args...).construct(
+          [&](auto post_builder) {
+            return on_success(
+              piecewise::builder(
+                [](Reusable &reusable_, auto&& builder, auto const &... args_) {
+                  return reusable_.replace(std::move(builder), args_...);
+                }
+              , reusable, std::move(post_builder), args...
+              )
+            );
+          }
+        , on_fail
+        );
+      }
+    };
+
+    template <typename ...Forwards>
+    bool is_unchanged(Forwards const &... args) const {
+      return current && *arguments == std::tie(args...);
+    }
+
+    template <typename Builder, typename ...Forwards>
+    std::shared_ptr<T const> replace(
+      Builder builder, Forwards const &... args
+    ) {
+      auto next_arguments = std::make_unique<std::tuple<Args...>>(args...);
+      std::shared_ptr<T const> next =
+        piecewise::make_shared(std::move(builder));
+      arguments = std::move(next_arguments);
+      current = next;
+      return next;
+    }
+
+    std::unique_ptr<std::tuple<Args...>> arguments;
+    std::shared_ptr<T const> current;
+  };
+
+  // An aggregate that is replaced while other threads read it. Readers take
+  // a snapshot with `load()` and never wait for a reload. Each version is
+  // destroyed when the last snapshot of it goes away.
+  template <typename T>
+  class Live {
+  public:
+    Live() = default;
+    Live(Live const &) = delete;
+    Live &operator=(Live const &) = delete;
+
+    // The current version, or null before the first successful reload
+    std::shared_ptr<T const> load() const noexcept {
+#if defined(__cpp_lib_atomic_shared_ptr)
+      return current.load(std::memory_order_acquire);
+#else
+      return std::atomic_load_explicit(&current, std::memory_order_acquire);
+#endif
+    }
+
+    // Constructs a new version from a pre-factory builder and publishes it.
+    // If a factory fails, `on_fail` receives the error, the current version
+    // stays live and this returns false. Reloads are serialized, so the
+    // `Reusable` members of the builder are never used concurrently.
+    template <typename Builder, typename OnFail>
+    bool reload(Builder&& pre_builder, OnFail&& on_fail) {
+      std::lock_guard<std::mutex> lock{writer};
+      return std::forward<Builder>(pre_builder).construct(
+        [this](auto builder) {
+          publish(piecewise::make_shared(std::move(builder)));
+          return true;
+        }
+      , [&](auto error) {
+          on_fail(std::move(error));
+          return false;
+        }
+      );
+    }
+
+  private:
+    void publish(std::shared_ptr<T const> next) noexcept {
+#if defined(__cpp_lib_atomic_shared_ptr)
+      current.store(std::move(next), std::memory_order_release);
+#else
+      std::atomic_store_explicit(
+        &current, std::move(next), std::memory_order_release
+      );
+#endif
+    }
+
+    std::mutex writer;
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<T const>> current;
+#else
+    std::shared_ptr<T const> current;
+#endif
+  };
+}}
+
+#endif
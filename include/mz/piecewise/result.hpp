@@ -0,0 +1,260 @@
+#ifndef UUID_7F21C0D4_9A3B_4E6C_B812_5D0E4A93C6F7
+#define UUID_7F21C0D4_9A3B_4E6C_B812_5D0E4A93C6F7
+
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/trace.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mz { namespace piecewise {
+  // Identifies a stateless error type. Ids are dense and start at 1, in the
+  // order error types are first used in the process, so they fit in a small
+  // integer but shouldn't be persisted.
+  using ErrorId = std::uint16_t;
+
+  namespace detail {
+    template <typename Error, typename = void>
+    struct ErrorDescription {
+      static char const *get() { return type_name<Error>(); }
+    };
+
+    template <typename Error>
+    struct ErrorDescription<Error, decltype(void(Error::description))> {
+      static char const *get() { return Error::description; }
+    };
+
+    class ErrorRegistry {
+    public:
+      static ErrorId add(char const *description) {
+        auto &instance = get();
+        std::lock_guard<std::mutex> lock{instance.mutex};
+        instance.descriptions.push_back(description);
+        return static_cast<ErrorId>(instance.descriptions.size());
+      }
+
+      static char const *description(ErrorId id) {
+        auto &instance = get();
+        std::lock_guard<std::mutex> lock{instance.mutex};
+        if (id == 0 || id > instance.descriptions.size()) return nullptr;
+        return instance.descriptions[id - 1u];
+      }
+
+    private:
+      static ErrorRegistry &get() {
+        static ErrorRegistry instance;
+        return instance;
+      }
+
+      std::mutex mutex;
+      std::vector<char const *> descriptions;
+    };
+
+    struct ResultValue {};
+    struct ResultError {};
+  }
+
+  // Held by a `Result` whose assignment threw while copying or moving the
+  // value. Its old value is gone by then.
+  struct ValuelessError {
+    static constexpr auto description = "Assignment of the value threw";
+  };
+
+  template <typename Error>
+  inline ErrorId error_id() {
+    static_assert(
+      std::is_empty<Error>::value
+    , "Only stateless errors can be stored as an error id"
+    );
+    static ErrorId const id = detail::ErrorRegistry::add(
+      detail::ErrorDescription<Error>::get()
+    );
+    return id;
+  }
+
+  // The error's static `description` if it has one, and otherwise the name
+  // of its type
+  inline char const *error_description(ErrorId id) {
+    return detail::ErrorRegistry::description(id);
+  }
+
+  // Either a `T` or the id of the stateless error that prevented its
+  // construction. Unlike `std::variant<T, Errors...>`, the error set doesn't
+  // need to be spelled out, and an error costs no more than its id.
+  template <typename T>
+  class Result final {
+  public:
+    using value_type = T;
+
+    Result(T value_) noexcept(std::is_nothrow_move_constructible<T>::value)
+      : error{0}
+    {
+      emplace(std::move(value_));
+    }
+
+    // Explicit, since any empty type is accepted as an error
+    template <
+      typename Error
+    , typename = std::enable_if_t<
+        std::is_empty<Error>::value && !std::is_convertible<Error, T>::value
+      >
+    > explicit Result(Error) : error{piecewise::error_id<Error>()} {}
+
+    // Initializes the value with whatever `make` returns, without a move
+    // since C++17
+    template <typename Make>
+    Result(detail::ResultValue, Make &&make) : error{0} {
+      ::new (static_cast<void *>(&storage)) T(std::forward<Make>(make)());
+    }
+
+    Result(Result const &other) : error{other.error} {
+      if (!error) emplace(*other);
+    }
+
+    Result(Result &&other) noexcept(
+      std::is_nothrow_move_constructible<T>::value
+    ) : error{other.error} {
+      if (!error) emplace(std::move(*other));
+    }
+
+    Result &operator=(Result const &other) {
+      if (this != &other) {
+        reset();
+        error = other.error;
+        if (!error) {
+          error = piecewise::error_id<ValuelessError>();
+          emplace(*other);
+          error = 0;
+        }
+      }
+      return *this;
+    }
+
+    Result &operator=(Result &&other) noexcept(
+      std::is_nothrow_move_constructible<T>::value
+    ) {
+      if (this != &other) {
+        reset();
+        error = other.error;
+        if (!error) {
+          error = piecewise::error_id<ValuelessError>();
+          emplace(std::move(*other));
+          error = 0;
+        }
+      }
+      return *this;
+    }
+
+    ~Result() { reset(); }
+
+    bool has_value() const noexcept { return error == 0; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    // Only valid when `has_value()`
+    T &operator*() & noexcept { return *pointer(); }
+    T const &operator*() const & noexcept { return *pointer(); }
+    T &&operator*() && noexcept { return std::move(*pointer()); }
+    T *operator->() noexcept { return pointer(); }
+    T const *operator->() const noexcept { return pointer(); }
+
+    template <typename U>
+    T value_or(U &&fallback) const & {
+      if (error) return static_cast<T>(std::forward<U>(fallback));
+      return **this;
+    }
+
+    template <typename U>
+    T value_or(U &&fallback) && {
+      if (error) return static_cast<T>(std::forward<U>(fallback));
+      return std::move(**this);
+    }
+
+    // 0 when `has_value()`
+    ErrorId error_id() const noexcept { return error; }
+
+    template <typename Error>
+    bool holds_error() const { return error == piecewise::error_id<Error>(); }
+
+    char const *error_description() const {
+      return piecewise::error_description(error);
+    }
+
+    // `Result<U>` holding `f(value)`, or this error
+    template <typename F>
+    auto map(F &&f) && {
+      using U = std::decay_t<decltype(std::forward<F>(f)(std::move(**this)))>;
+      if (error) return Result<U>{detail::ResultError{}, error};
+      return Result<U>{
+        detail::ResultValue{}
+      , [&]() -> U { return std::forward<F>(f)(std::move(**this)); }
+      };
+    }
+
+    template <typename F>
+    auto map(F &&f) const & {
+      return Result{*this}.map(std::forward<F>(f));
+    }
+
+    // `f(value)`, which must return a `Result`, or this error
+    template <typename F>
+    auto and_then(F &&f) && {
+      using R = std::decay_t<decltype(std::forward<F>(f)(std::move(**this)))>;
+      if (error) return R{detail::ResultError{}, error};
+      return std::forward<F>(f)(std::move(**this));
+    }
+
+    template <typename F>
+    auto and_then(F &&f) const & {
+      return Result{*this}.and_then(std::forward<F>(f));
+    }
+
+    // Propagates an error id
+    Result(detail::ResultError, ErrorId error_) noexcept : error{error_} {}
+
+  private:
+    template <typename ...Args>
+    void emplace(Args&&... args) {
+      ::new (static_cast<void *>(&storage)) T(std::forward<Args>(args)...);
+    }
+
+    T *pointer() noexcept { return reinterpret_cast<T *>(&storage); }
+    T const *pointer() const noexcept {
+      return reinterpret_cast<T const *>(&storage);
+    }
+
+    void reset() noexcept {
+      if (!error) pointer()->~T();
+    }
+
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    ErrorId error;
+  };
+
+  // Adds `Foo::result` to a `Helpers` type that also derives from
+  // `ResultHelper<Helpers<Foo>>`
+  template <typename T>
+  class ResultHelper {
+  public:
+    // Constructs in place, or records which error occurred. Errors must be
+    // stateless; use `variant` for errors that carry data.
+    template <typename ...Args>
+    static auto result(Args&&... args) {
+      using Result = piecewise::Result<typename T::Implementation>;
+      return BuilderHelper<T>::builder(std::forward<Args>(args)...).construct(
+        [](auto builder) {
+          return Result{
+            detail::ResultValue{}
+          , [&] { return std::move(builder).construct(); }
+          };
+        }
+      , [](auto error) { return Result{error}; }
+      );
+    }
+  };
+}}
+
+#endif
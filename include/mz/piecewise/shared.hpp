@@ -0,0 +1,107 @@
+#ifndef UUID_D61F0B85_3E2A_47C9_9B74_A08C5E2D1F93
+#define UUID_D61F0B85_3E2A_47C9_9B74_A08C5E2D1F93
+
+#if __cplusplus >= 201703L
+
+#include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/in_place.hpp>
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mz { namespace piecewise {
+  // One lazily constructed `T` that several aggregates depend on. The first
+  // builder from `builder()` that gets constructed runs its factory, exactly
+  // once even under concurrent first use. After that, builders from here
+  // construct a `std::reference_wrapper<T>` to the same instance, or fail
+  // with the same error, and any builders they were given are ignored.
+  template <typename T, typename ...Errors>
+  class Shared {
+  public:
+    Shared() = default;
+    Shared(Shared const &) = delete;
+    Shared &operator=(Shared const &) = delete;
+
+    ~Shared() {
+      if (value != nullptr) value->~T();
+    }
+
+    // The process-wide instance used by `mp::shared`
+    static Shared &instance() {
+      static Shared shared;
+      return shared;
+    }
+
+    template <typename Builder>
+    auto builder(Builder&& pre_builder) {
+      return piecewise::builder(
+        SharedFactory{*this}, std::forward<Builder>(pre_builder)
+      );
+    }
+
+  private:
+    struct SharedFactory {
+      using result_type = std::reference_wrapper<T>;
+
+      Shared &shared;
+
+      template <typename OnSuccess, typename OnFail, typename Builder>
+      auto operator()(
+        OnSuccess&& on_success, OnFail&& on_fail, Builder&& pre_builder
+      ) const {
+        shared.initialize(std::forward<Builder>(pre_builder));
+        if constexpr (sizeof...(Errors) > 0) {
+          if (shared.error) {
+            return std::visit(
+              [&](auto const &error) { return on_fail(error); }, *shared.error
+            );
+          }
+        }
+        return on_success(
+          piecewise::builder(
+            [](T &instance) { return std::ref(instance); }, *shared.value
+          )
+        );
+      }
+    };
+
+    template <typename Builder>
+    void initialize(Builder&& pre_builder) {
+      std::call_once(once, [&] {
+        std::forward<Builder>(pre_builder).construct(
+          [&](auto builder) {
+            value = piecewise::construct_at(&storage, std::move(builder));
+          }
+        , [&](auto error_) { error.emplace(std::move(error_)); }
+        );
+      });
+    }
+
+    std::once_flag once;
+    // Constructed with `construct_at`, which never moves the instance on any
+    // compiler, so `T` doesn't need to be movable
+    alignas(T) unsigned char storage[sizeof(T)];
+    T *value = nullptr;
+    std::optional<
+      std::conditional_t<
+        sizeof...(Errors) == 0, std::monostate, std::variant<Errors...>
+      >
+    > error;
+  };
+
+  // A nested pre-factory builder for the process-wide `Shared<T, Errors...>`
+  template <typename T, typename ...Errors, typename Builder>
+  inline auto shared(Builder&& pre_builder) {
+    return Shared<T, Errors...>::instance().builder(
+      std::forward<Builder>(pre_builder)
+    );
+  }
+}}
+
+#endif
+
+#endif
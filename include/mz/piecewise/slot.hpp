@@ -0,0 +1,72 @@
+#ifndef UUID_7D2A9E51_3C84_4F0B_9E26_B1A4C8F05D37
+#define UUID_7D2A9E51_3C84_4F0B_9E26_B1A4C8F05D37
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mz { namespace piecewise { namespace detail {
+  // Storage for a callback result that is produced in one place and returned
+  // from another. `Slot<void>` and `Slot<T&>` make the same code work for
+  // callbacks that return nothing or a reference.
+  template <typename T>
+  class Slot {
+  public:
+    Slot() = default;
+    Slot(Slot const &) = delete;
+    Slot &operator=(Slot const &) = delete;
+
+    ~Slot() {
+      if (full) get().~T();
+    }
+
+    template <typename Callback>
+    void fill(Callback&& callback) {
+      ::new (static_cast<void *>(&storage)) T(callback());
+      full = true;
+    }
+
+    bool is_full() const { return full; }
+
+    T take() { return std::move(get()); }
+
+  private:
+    T &get() { return *reinterpret_cast<T *>(&storage); }
+
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    bool full = false;
+  };
+
+  template <typename T>
+  class Slot<T&> {
+  public:
+    template <typename Callback>
+    void fill(Callback&& callback) { pointer = &callback(); }
+
+    bool is_full() const { return pointer != nullptr; }
+
+    T &take() { return *pointer; }
+
+  private:
+    T *pointer = nullptr;
+  };
+
+  template <>
+  class Slot<void> {
+  public:
+    template <typename Callback>
+    void fill(Callback&& callback) {
+      callback();
+      full = true;
+    }
+
+    bool is_full() const { return full; }
+
+    void take() {}
+
+  private:
+    bool full = false;
+  };
+}}}
+
+#endif
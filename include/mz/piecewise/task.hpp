@@ -0,0 +1,204 @@
+#ifndef UUID_5A0C6E3F_94B2_4D7A_B1E8_3F6D2C9A7E14
+#define UUID_5A0C6E3F_94B2_4D7A_B1E8_3F6D2C9A7E14
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+  #define MZ_PIECEWISE_COROUTINES 1
+#endif
+
+#if defined(MZ_PIECEWISE_COROUTINES)
+
+#include <mz/piecewise/slot.hpp>
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+namespace mz { namespace piecewise {
+  template <typename T = void>
+  class Task;
+
+  namespace detail {
+    class TaskPromiseBase {
+    public:
+      // Resumes whoever awaited the task, if anyone
+      struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<Promise> handle
+        ) const noexcept {
+          auto continuation = handle.promise().continuation;
+          if (continuation) return continuation;
+          return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+      };
+
+      // Tasks are lazy. Nothing runs until the task is awaited or started.
+      std::suspend_always initial_suspend() const noexcept { return {}; }
+      FinalAwaiter final_suspend() const noexcept { return {}; }
+
+      void unhandled_exception() noexcept {
+        exception = std::current_exception();
+      }
+
+      void rethrow() const {
+        if (exception) std::rethrow_exception(exception);
+      }
+
+      std::coroutine_handle<> continuation;
+
+    private:
+      std::exception_ptr exception;
+    };
+
+    template <typename T>
+    class TaskPromise : public TaskPromiseBase {
+    public:
+      Task<T> get_return_object() noexcept;
+
+      template <typename Value>
+      void return_value(Value&& value) {
+        result.fill([&]() -> T { return std::forward<Value>(value); });
+      }
+
+      T take() {
+        rethrow();
+        return result.take();
+      }
+
+    private:
+      Slot<T> result;
+    };
+
+    template <>
+    class TaskPromise<void> : public TaskPromiseBase {
+    public:
+      Task<void> get_return_object() noexcept;
+
+      void return_void() const noexcept {}
+
+      void take() const { rethrow(); }
+    };
+  }
+
+  // A lazily started coroutine that produces a `T`. Awaiting a task starts it
+  // and resumes the awaiting coroutine once it finishes. A default constructed
+  // `Task<void>` is already finished.
+  template <typename T>
+  class Task {
+  public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle_)
+      : handle{handle_}
+    {}
+
+    Task(Task &&other) noexcept
+      : handle{std::exchange(other.handle, nullptr)}
+    {}
+
+    Task &operator=(Task &&other) noexcept {
+      if (this != &other) {
+        if (handle) handle.destroy();
+        handle = std::exchange(other.handle, nullptr);
+      }
+      return *this;
+    }
+
+    ~Task() {
+      if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return !handle || handle.done(); }
+
+    std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<> awaiting
+    ) const noexcept {
+      handle.promise().continuation = awaiting;
+      return handle;
+    }
+
+    T await_resume() const {
+      if constexpr (std::is_void_v<T>) {
+        if (handle) handle.promise().take();
+      } else {
+        return handle.promise().take();
+      }
+    }
+
+    // Starts a task that nobody awaits, e.g. from an event loop. It runs until
+    // its first suspension point.
+    void start() const {
+      if (handle && !handle.done()) handle.resume();
+    }
+
+    bool done() const noexcept { return !handle || handle.done(); }
+
+    // The result of a finished task
+    T get() const { return await_resume(); }
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  namespace detail {
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept {
+      return Task<T>{std::coroutine_handle<TaskPromise>::from_promise(*this)};
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+      return Task<void>{
+        std::coroutine_handle<TaskPromise>::from_promise(*this)
+      };
+    }
+
+    // The body of `construct_async`
+    template <
+      typename Result
+    , typename Owned, typename OnSuccess, typename OnFail
+    > Task<Result> run_async(
+      Owned owned, OnSuccess on_success, OnFail on_fail
+    ) {
+      Slot<Result> result;
+      co_await std::move(owned).construct(
+        [&](auto builder) -> Task<> {
+          result.fill([&]() -> Result {
+            return on_success(std::move(builder).own());
+          });
+          return {};
+        }
+      , [&](auto error) -> Task<> {
+          result.fill([&]() -> Result { return on_fail(std::move(error)); });
+          return {};
+        }
+      );
+      co_return result.take();
+    }
+  }
+
+  // Like `builder.construct`, but the factory may be a coroutine returning
+  // `Task<>`, and so may suspend. The returned task owns the builder (see
+  // `Builder::own`) and yields whatever the callbacks return. The success
+  // callback receives an owning builder as well.
+  template <
+    typename Result = void
+  , typename Builder, typename OnSuccess, typename OnFail
+  > inline Task<Result> construct_async(
+    Builder builder, OnSuccess on_success, OnFail on_fail
+  ) {
+    // Owned before the task is created, since it starts lazily
+    return detail::run_async<Result>(
+      std::move(builder).own(), std::move(on_success), std::move(on_fail)
+    );
+  }
+}}
+
+#endif
+
+#endif
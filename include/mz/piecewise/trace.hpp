@@ -0,0 +1,225 @@
+#ifndef UUID_4A7E2C91_B35D_4F08_8E6A_C1D94F27B053
+#define UUID_4A7E2C91_B35D_4F08_8E6A_C1D94F27B053
+
+#include <mz/piecewise/builder.hpp>
+
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+// A tracer is a type with the static member function templates below. `T` is
+// the type being constructed and `depth` its nesting depth on the calling
+// thread, starting at 0 for the outermost factory or constructor. Pass one as
+// the second template argument of `Helpers`, or wrap the builders passed to
+// `multifail` with `traced_builders<Tracer>`. Without a tracer none of this
+// code is instantiated.
+//
+//   struct Tracer {
+//     template <typename T> static void factory_start(std::size_t depth);
+//     template <typename T> static void factory_success(std::size_t depth);
+//     template <typename T, typename Error>
+//     static void factory_failure(std::size_t depth, Error const &error);
+//     template <typename T> static void constructor_start(std::size_t depth);
+//     template <typename T> static void constructor_end(std::size_t depth);
+//   };
+//
+// Factories run in continuation passing style, so a factory counts as
+// finished when it calls its success or failure callback. Its siblings run
+// from inside that callback, at the same depth.
+namespace mz { namespace piecewise {
+  namespace detail {
+    template <typename T>
+    inline std::string pretty_type_name() {
+    #if defined(_MSC_VER)
+      std::string name = __FUNCSIG__;
+      auto begin = name.find("pretty_type_name<") + 17;
+      auto end = name.rfind(">(void)");
+    #elif defined(__clang__) || defined(__GNUC__)
+      std::string name = __PRETTY_FUNCTION__;
+      auto begin = name.find("T = ") + 4;
+      auto end = name.find_first_of(";]", begin);
+    #else
+      std::string name;
+      std::size_t begin = 0, end = 0;
+    #endif
+      if (begin >= end || end == std::string::npos) return typeid(T).name();
+      return name.substr(begin, end - begin);
+    }
+
+    // Per thread nesting depths, kept per tracer so that tracers don't see
+    // each other's events
+    template <typename Tracer>
+    struct TraceDepth {
+      static thread_local std::size_t factories;
+      static thread_local std::size_t constructors;
+    };
+
+    template <typename Tracer>
+    thread_local std::size_t TraceDepth<Tracer>::factories = 0;
+
+    template <typename Tracer>
+    thread_local std::size_t TraceDepth<Tracer>::constructors = 0;
+
+    template <typename Tracer, typename T>
+    struct Trace {
+      using Depth = TraceDepth<Tracer>;
+
+      static std::size_t factory_start() {
+        auto depth = Depth::factories++;
+        Tracer::template factory_start<T>(depth);
+        return depth;
+      }
+
+      static void factory_success(std::size_t depth) {
+        Depth::factories = depth;
+        Tracer::template factory_success<T>(depth);
+      }
+
+      template <typename Error>
+      static void factory_failure(std::size_t depth, Error const &error) {
+        Depth::factories = depth;
+        Tracer::template factory_failure<T>(depth, error);
+      }
+
+      // Reports the end of a constructor when the object it returns has been
+      // initialized
+      class Construction {
+      public:
+        Construction() : depth{Depth::constructors++} {
+          Tracer::template constructor_start<T>(depth);
+        }
+        Construction(Construction const &) = delete;
+        Construction &operator=(Construction const &) = delete;
+
+        ~Construction() {
+          Depth::constructors = depth;
+          Tracer::template constructor_end<T>(depth);
+        }
+
+      private:
+        std::size_t depth;
+      };
+
+      // Runs `factory` with callbacks that report how it finished
+      template <
+        typename Factory, typename Constructor
+      , typename OnSuccess, typename OnFail, typename ...Args
+      > static auto factory(
+        Factory&& factory_
+      , Constructor&& constructor
+      , OnSuccess& on_success, OnFail& on_fail
+      , Args&&... args
+      ) {
+        auto depth = factory_start();
+        return std::forward<Factory>(factory_)(
+          std::forward<Constructor>(constructor)
+        , [&on_success, depth](auto&& builder) {
+            factory_success(depth);
+            return on_success(std::forward<decltype(builder)>(builder));
+          }
+        , [&on_fail, depth](auto&& error) {
+            factory_failure(depth, error);
+            return on_fail(std::forward<decltype(error)>(error));
+          }
+        , std::forward<Args>(args)...
+        );
+      }
+    };
+
+    template <typename Callback, typename = void>
+    struct TracedTypeOf {
+      using type = Callback;
+    };
+
+    template <typename Callback>
+    struct TracedTypeOf<Callback, decltype(void(
+      std::declval<typename Callback::result_type *>()
+    ))> {
+      using type = typename Callback::result_type;
+    };
+
+    template <typename Builder>
+    struct TracedType {
+      using type = Builder;
+    };
+
+    // Builders made by `Helpers` name the type they construct
+    template <typename Callback, typename ...Forwards>
+    struct TracedType<Builder<Callback, Forwards...>>
+      : TracedTypeOf<Callback>
+    {};
+
+    // The post-factory builder of a traced pre-factory builder
+    template <typename Tracer, typename T, typename Builder>
+    class TracedPostBuilder {
+    public:
+      explicit TracedPostBuilder(Builder builder_)
+        : builder{std::move(builder_)}
+      {}
+
+      template <typename ...Args>
+      auto construct(Args&&... args) && {
+        typename Trace<Tracer, T>::Construction construction;
+        return std::move(builder).construct(std::forward<Args>(args)...);
+      }
+
+    private:
+      Builder builder;
+    };
+
+    // Wraps a nested pre-factory builder of `multifail`
+    template <typename Tracer, typename Builder>
+    class TracedBuilder {
+    public:
+      using result_type = typename TracedType<Builder>::type;
+
+      explicit TracedBuilder(Builder builder_)
+        : builder{std::move(builder_)}
+      {}
+
+      template <typename OnSuccess, typename OnFail>
+      auto construct(OnSuccess&& on_success, OnFail&& on_fail) && {
+        using Trace = detail::Trace<Tracer, result_type>;
+        auto depth = Trace::factory_start();
+        return std::move(builder).construct(
+          [&on_success, depth](auto post) {
+            Trace::factory_success(depth);
+            return on_success(
+              TracedPostBuilder<Tracer, result_type, decltype(post)>{
+                std::move(post)
+              }
+            );
+          }
+        , [&on_fail, depth](auto&& error) {
+            Trace::factory_failure(depth, error);
+            return on_fail(std::forward<decltype(error)>(error));
+          }
+        );
+      }
+
+    private:
+      Builder builder;
+    };
+  }
+
+  // Like `builders`, but reports each builder's factory and constructor to
+  // `Tracer`. Builders made by a traced `Helpers` already report themselves.
+  template <typename Tracer, typename ...Builders>
+  inline auto traced_builders(Builders... builders) {
+    return std::tuple<detail::TracedBuilder<Tracer, Builders>...>{
+      detail::TracedBuilder<Tracer, Builders>{std::move(builders)}...
+    };
+  }
+
+  // A readable name for `T`, for tracers that report types
+  template <typename T>
+  inline char const *type_name() {
+    static std::string const name = detail::pretty_type_name<T>();
+    return name.c_str();
+  }
+}}
+
+#endif
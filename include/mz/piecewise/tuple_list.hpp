@@ -1,6 +1,7 @@
 #ifndef UUID_D1091115_FC3B_4BB0_BCB7_0F0137449C49
 #define UUID_D1091115_FC3B_4BB0_BCB7_0F0137449C49
 
+#include <initializer_list>
 #include <tuple>
 #include <type_traits>
 
@@ -12,11 +13,25 @@ namespace mz { namespace piecewise { namespace tuple_list {
   };
 
   namespace detail {
+    inline constexpr bool all_of(std::initializer_list<bool> values) {
+      for (bool value : values) if (!value) return false;
+      return true;
+    }
+
+    // Elements are moved out of references, and `std::make_tuple` decays them
+    template <typename ...Ts>
+    constexpr bool nothrow_moves() {
+      return all_of({
+        true
+      , std::is_nothrow_move_constructible<std::decay_t<Ts>>::value...
+      });
+    }
+
     template <typename T, typename ...Ts, std::size_t ...Indices>
     inline auto split_impl(
       std::tuple<T, Ts...> list
     , std::index_sequence<Indices...>
-    )-> split_result<T, Ts...> {
+    ) noexcept(nothrow_moves<T, Ts...>())-> split_result<T, Ts...> {
       return {
         std::move(std::get<0>(list))
       , std::make_tuple(std::move(std::get<Indices+1>(list))...)
@@ -36,7 +51,7 @@ namespace mz { namespace piecewise { namespace tuple_list {
       std::tuple<Ts...> reverse_tail
     , std::index_sequence<Indices...>
     , T reverse_head
-    ) {
+    ) noexcept(nothrow_moves<Ts..., T>()) {
       return std::make_tuple(
         std::move(std::get<Indices>(reverse_tail))...
       , std::move(reverse_head)
@@ -51,7 +66,12 @@ namespace mz { namespace piecewise { namespace tuple_list {
   }
 
   template <typename T, typename ...Ts>
-  inline auto split(std::tuple<T, Ts...> list) {
+  inline auto split(std::tuple<T, Ts...> list) noexcept(noexcept(
+    detail::split_impl(
+      std::move(list)
+    , std::make_index_sequence<sizeof...(Ts)>{}
+    )
+  )) {
     return detail::split_impl(
       std::move(list)
     , std::make_index_sequence<sizeof...(Ts)>{}
@@ -59,7 +79,15 @@ namespace mz { namespace piecewise { namespace tuple_list {
   }
 
   template <typename ...Ts, typename T>
-  inline auto combine(std::tuple<Ts...> reverse_tail, T reverse_head) {
+  inline auto combine(
+    std::tuple<Ts...> reverse_tail, T reverse_head
+  ) noexcept(noexcept(
+    detail::combine_impl(
+      std::move(reverse_tail)
+    , std::make_index_sequence<sizeof...(Ts)>{}
+    , std::move(reverse_head)
+    )
+  )) {
     return detail::combine_impl(
       std::move(reverse_tail)
     , std::make_index_sequence<sizeof...(Ts)>{}
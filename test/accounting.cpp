@@ -0,0 +1,562 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 201703L
+  #include <string_view>
+#endif
+
+// Counts every heap allocation in the test executable. Only differences
+// across a construction are checked, so other tests are unaffected.
+namespace {
+  std::atomic<std::size_t> heap_allocations{0};
+}
+
+// GCC warns about the `free` once these are inlined into allocator code
+#if !defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 11
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void *operator new(std::size_t size) {
+  ++heap_allocations;
+  if (void *memory = std::malloc(size == 0 ? 1 : size)) return memory;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+#if !defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 11
+  #pragma GCC diagnostic pop
+#endif
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct Counts {
+    int copies;
+    int moves;
+    std::size_t allocations;
+  };
+
+  int copies = 0;
+  int moves = 0;
+
+  // An argument that reports how often it is copied or moved on its way to
+  // the member it initializes
+  struct Tracked {
+    int value;
+
+    explicit Tracked(int value_) : value{value_} {}
+    Tracked(Tracked const &other) : value{other.value} { ++copies; }
+    Tracked(Tracked &&other) noexcept : value{other.value} { ++moves; }
+    Tracked &operator=(Tracked const &) = delete;
+    Tracked &operator=(Tracked &&) = delete;
+  };
+
+  // Runs `construction` and reports what it cost
+  template <typename Construction>
+  Counts account(Construction &&construction) {
+    copies = 0;
+    moves = 0;
+    std::size_t before = heap_allocations;
+    construction();
+    return {copies, moves, heap_allocations - before};
+  }
+
+  struct NegativeError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  struct EmptyBufferError {
+    static constexpr auto description = "Buffer is empty";
+  };
+
+  // Takes its argument by value at every step, like the types in the other
+  // tests. Each step costs one move.
+  class Part final : public mp::Helpers<Part> {
+  public:
+    int get_value() const { return tracked.value; }
+
+  private:
+    friend class mp::Helpers<Part>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , Tracked tracked
+      ) {
+        if (tracked.value < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, std::move(tracked)));
+      };
+    }
+
+    Tracked tracked;
+
+  public:
+    Part(typename mp::Helpers<Part>::Private, Tracked tracked_)
+      : tracked{std::move(tracked_)}
+    {}
+  };
+
+  // Owns a heap allocation, made by its constructor
+  class Buffer final : public mp::Helpers<Buffer> {
+  public:
+    std::size_t get_size() const { return data.size(); }
+
+  private:
+    friend class mp::Helpers<Buffer>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::size_t size
+      ) {
+        if (size == 0) return on_fail(EmptyBufferError{});
+        return on_success(mp::builder(constructor, size));
+      };
+    }
+
+    std::vector<int> data;
+
+  public:
+    Buffer(typename mp::Helpers<Buffer>::Private, std::size_t size)
+      : data(size)
+    {}
+  };
+
+  struct Plain {
+    Tracked tracked;
+  };
+
+  // The `Aggregate<A, A, B>` shape from multifail.cpp
+  template <typename T, typename U, typename V>
+  class Aggregate final : public mp::Helpers<Aggregate<T, U, V>> {
+  public:
+    T const &get_t() const { return t; }
+    U const &get_u() const { return u; }
+    V const &get_v() const { return v; }
+
+  private:
+    friend class mp::Helpers<Aggregate>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto t_builder, auto u_builder, auto v_builder
+      , Tracked tracked
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(
+            std::move(t_builder), std::move(u_builder), std::move(v_builder)
+          )
+        , mp::arguments(std::move(tracked))
+        );
+      };
+    }
+
+  public:
+    template <typename TBuilder, typename UBuilder, typename VBuilder>
+    Aggregate(
+      typename mp::Helpers<Aggregate>::Private
+    , Tracked tracked_
+    , TBuilder t_builder, UBuilder u_builder, VBuilder v_builder
+    ) : t{std::move(t_builder).construct()}
+      , tracked{std::move(tracked_)}
+      , u{std::move(u_builder).construct()}
+      , v{std::move(v_builder).construct()}
+    {}
+
+  private:
+    T t;
+    Tracked tracked;
+    U u;
+    V v;
+  };
+
+  struct InvalidNameError {
+    static constexpr auto description = "Name contains a space";
+  };
+
+  // Takes an owning copy of its argument before validating it
+  class CopiedName final : public mp::Helpers<CopiedName> {
+  public:
+    std::string const &get_name() const { return name; }
+
+  private:
+    friend class mp::Helpers<CopiedName>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name
+      ) {
+        if (name.find(' ') != std::string::npos) {
+          return on_fail(InvalidNameError{});
+        }
+        return on_success(mp::builder(constructor, std::move(name)));
+      };
+    }
+
+    std::string name;
+
+  public:
+    CopiedName(typename mp::Helpers<CopiedName>::Private, std::string name_)
+      : name{std::move(name_)}
+    {}
+  };
+
+  // Validates a borrowed `View` of its argument, and only copies it in the
+  // constructor
+  template <typename View>
+  class BorrowedName final : public mp::Helpers<BorrowedName<View>> {
+  public:
+    std::string const &get_name() const { return name; }
+
+  private:
+    friend class mp::Helpers<BorrowedName>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , View name
+      ) {
+        if (name.find(' ') != std::decay_t<View>::npos) {
+          return on_fail(InvalidNameError{});
+        }
+        return on_success(
+          mp::builder(constructor, mp::owned<std::string>(name))
+        );
+      };
+    }
+
+    std::string name;
+
+  public:
+    BorrowedName(
+      typename mp::Helpers<BorrowedName>::Private, std::string name_
+    ) : name{std::move(name_)}
+    {}
+  };
+
+  // Too long for the small string optimization
+  std::string const valid_name = "a_name_that_is_long_enough_to_allocate";
+  std::string const invalid_name = "a name that is long enough to allocate";
+
+  // The size of the constructed name, or 0 on failure
+  template <typename Builder>
+  std::size_t name_size(Builder builder) {
+    return std::move(builder).construct(
+      [](auto post) { return std::move(post).construct().get_name().size(); }
+    , [](auto) { return std::size_t{0}; }
+    );
+  }
+
+  template <typename Builder>
+  int construct_value(Builder builder) {
+    return std::move(builder).construct(
+      [](auto post) { return std::move(post).construct().get_value(); }
+    , [](auto) { return -1; }
+    );
+  }
+}
+
+SCENARIO("copy, move and allocation accounting") {
+  WHEN("a single type is constructed") {
+    int value = 0;
+    auto counts = account([&] {
+      value = construct_value(Part::builder(Tracked{1}));
+    });
+
+    THEN("the argument is moved into the factory, the constructor and the "
+         "member, and never copied") {
+      REQUIRE(value == 1);
+      REQUIRE(counts.copies == 0);
+      REQUIRE(counts.moves == 3);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a single type is constructed from an lvalue") {
+    Tracked tracked{2};
+    int value = 0;
+    auto counts = account([&] {
+      value = construct_value(Part::builder(tracked));
+    });
+
+    THEN("the only copy is the one the factory asks for") {
+      REQUIRE(value == 2);
+      REQUIRE(counts.copies == 1);
+      REQUIRE(counts.moves == 2);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a factory fails") {
+    auto counts = account([&] {
+      construct_value(Part::builder(Tracked{-1}));
+    });
+
+    THEN("nothing past the factory is paid for") {
+      REQUIRE(counts.copies == 0);
+      REQUIRE(counts.moves == 1);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a type that allocates is constructed") {
+    std::size_t size = 0;
+    auto counts = account([&] {
+      size = Buffer::builder(std::size_t{16}).construct(
+        [](auto post) { return std::move(post).construct().get_size(); }
+      , [](auto) { return std::size_t{0}; }
+      );
+    });
+
+    THEN("only its own allocation is made") {
+      REQUIRE(size == 16);
+      REQUIRE(counts.allocations == 1);
+    }
+  }
+
+  WHEN("a wrapped type is constructed") {
+    int value = 0;
+    auto counts = account([&] {
+      value = mp::wrapper<Plain>(Tracked{3}).construct(
+        [](auto post) { return std::move(post).construct().tracked.value; }
+      , [](auto) { return -1; }
+      );
+    });
+
+    THEN("the argument is moved straight into the member") {
+      REQUIRE(value == 3);
+      REQUIRE(counts.copies == 0);
+      REQUIRE(counts.moves == 1);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("an aggregate is constructed with multifail") {
+    int sum = 0;
+    auto counts = account([&] {
+      sum = Aggregate<Part, Part, Plain>::builder(
+        Part::builder(Tracked{1})
+      , Part::builder(Tracked{2})
+      , mp::wrapper<Plain>(Tracked{3})
+      , Tracked{4}
+      ).construct(
+        [](auto post) {
+          auto aggregate = std::move(post).construct();
+          return aggregate.get_t().get_value()
+            + aggregate.get_u().get_value()
+            + aggregate.get_v().tracked.value;
+        }
+      , [](auto) { return -1; }
+      );
+    });
+
+    THEN("it costs exactly what its parts and its own argument cost") {
+      REQUIRE(sum == 6);
+      REQUIRE(counts.copies == 0);
+      // 3 for each `Part`, 1 for `Plain`, and 3 for the aggregate's own
+      // argument
+      REQUIRE(counts.moves == 3 + 3 + 1 + 3);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a nested factory of an aggregate fails") {
+    auto counts = account([&] {
+      Aggregate<Part, Part, Plain>::builder(
+        Part::builder(Tracked{1})
+      , Part::builder(Tracked{-2})
+      , mp::wrapper<Plain>(Tracked{3})
+      , Tracked{4}
+      ).construct(
+        [](auto) {}
+      , mp::handler([](NegativeError) {})
+      );
+    });
+
+    THEN("only the factories that ran are paid for") {
+      REQUIRE(counts.copies == 0);
+      // The aggregate's factory and both `Part` factories
+      REQUIRE(counts.moves == 3);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a factory that copies its argument rejects it") {
+    auto counts = account([&] {
+      name_size(CopiedName::builder(invalid_name));
+    });
+
+    THEN("the copy is made and thrown away") {
+      REQUIRE(counts.allocations == 1);
+    }
+  }
+
+  WHEN("a factory that borrows its argument rejects it") {
+    using Name = BorrowedName<std::string const &>;
+    std::size_t size = 1;
+    auto counts = account([&] {
+      size = name_size(Name::builder(invalid_name));
+    });
+
+    THEN("nothing is allocated") {
+      REQUIRE(size == 0);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a factory that borrows its argument accepts it") {
+    using Name = BorrowedName<std::string const &>;
+    std::size_t size = 0;
+    auto counts = account([&] {
+      size = name_size(Name::builder(valid_name));
+    });
+
+    THEN("the only copy is made by the constructor") {
+      REQUIRE(size == valid_name.size());
+      REQUIRE(counts.allocations == 1);
+    }
+  }
+
+  WHEN("many borrowed arguments are rejected") {
+    using Name = BorrowedName<std::string const &>;
+    std::vector<std::string> names(100, invalid_name);
+    std::size_t rejected = 0;
+    auto counts = account([&] {
+      for (auto const &name : names) {
+        rejected += name_size(Name::builder(name)) == 0 ? 1 : 0;
+      }
+    });
+
+    THEN("nothing is allocated") {
+      REQUIRE(rejected == names.size());
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a later member of an aggregate rejects its argument") {
+    auto copied = account([&] {
+      Aggregate<CopiedName, CopiedName, Plain>::builder(
+        CopiedName::builder(valid_name)
+      , CopiedName::builder(invalid_name)
+      , mp::wrapper<Plain>(Tracked{3})
+      , Tracked{4}
+      ).construct([](auto) {}, [](auto) {});
+    });
+
+    using Name = BorrowedName<std::string const &>;
+    auto borrowed = account([&] {
+      Aggregate<Name, Name, Plain>::builder(
+        Name::builder(valid_name)
+      , Name::builder(invalid_name)
+      , mp::wrapper<Plain>(Tracked{3})
+      , Tracked{4}
+      ).construct([](auto) {}, [](auto) {});
+    });
+
+    THEN("borrowing members copy nothing, even for the valid argument") {
+      REQUIRE(copied.allocations == 2);
+      REQUIRE(borrowed.allocations == 0);
+    }
+  }
+
+  WHEN("a post-factory builder with a borrowed argument is owned") {
+    using Name = BorrowedName<std::string const &>;
+    std::string input = valid_name;
+    std::string name = Name::builder(input).construct(
+      [&](auto post) {
+        auto owning = std::move(post).own();
+        input.assign("changed");
+        return std::move(owning).construct().get_name();
+      }
+    , [](auto) { return std::string{}; }
+    );
+
+    THEN("it holds its own copy") {
+      REQUIRE(name == valid_name);
+    }
+  }
+
+#if __cplusplus >= 201703L
+  WHEN("a factory that takes a string view rejects a literal") {
+    using Name = BorrowedName<std::string_view>;
+    auto counts = account([&] {
+      name_size(Name::builder("a name that is long enough to allocate"));
+    });
+
+    THEN("nothing is allocated") {
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a factory that takes a string view accepts a literal") {
+    using Name = BorrowedName<std::string_view>;
+    std::size_t size = 0;
+    auto counts = account([&] {
+      size = name_size(Name::builder("a_name_that_is_long_enough_to_allocate"));
+    });
+
+    THEN("the only copy is made by the constructor") {
+      REQUIRE(size == valid_name.size());
+      REQUIRE(counts.allocations == 1);
+    }
+  }
+
+  WHEN("the optional helper is used") {
+    int value = 0;
+    auto counts = account([&] {
+      auto part = Part::optional(Tracked{5}).construct([](auto) {});
+      value = part->get_value();
+    });
+
+    THEN("it costs the same as constructing directly") {
+      REQUIRE(value == 5);
+      REQUIRE(counts.copies == 0);
+      REQUIRE(counts.moves == 3);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("the variant helper is used") {
+    int value = 0;
+    auto counts = account([&] {
+      auto part = Part::variant<NegativeError>(Tracked{6});
+      value = std::get<Part>(part).get_value();
+    });
+
+    THEN("it costs the same as constructing directly") {
+      REQUIRE(value == 6);
+      REQUIRE(counts.copies == 0);
+      REQUIRE(counts.moves == 3);
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+#endif
+}
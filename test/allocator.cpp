@@ -0,0 +1,387 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+
+#if __cplusplus >= 201703L
+
+#include <mz/piecewise/allocator.hpp>
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  // Counts what is allocated from it
+  class CountingResource final : public std::pmr::memory_resource {
+  public:
+    explicit CountingResource(std::pmr::memory_resource &upstream_)
+      : upstream{upstream_}
+    {}
+
+    std::size_t allocations = 0;
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+      ++allocations;
+      return upstream.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(
+      void *pointer, std::size_t bytes, std::size_t alignment
+    ) override {
+      upstream.deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(
+      std::pmr::memory_resource const &other
+    ) const noexcept override {
+      return this == &other;
+    }
+
+    std::pmr::memory_resource &upstream;
+  };
+
+  // Makes any allocation from the default resource throw
+  class NoDefaultResource {
+  public:
+    NoDefaultResource()
+      : previous{std::pmr::set_default_resource(
+          std::pmr::null_memory_resource()
+        )}
+    {}
+    NoDefaultResource(NoDefaultResource const &) = delete;
+    NoDefaultResource &operator=(NoDefaultResource const &) = delete;
+
+    ~NoDefaultResource() { std::pmr::set_default_resource(previous); }
+
+  private:
+    std::pmr::memory_resource *previous;
+  };
+
+  struct EmptyNameError {
+    static constexpr auto description = "Name is empty";
+  };
+
+  struct PortRangeError {
+    static constexpr auto description = "Port is out of range";
+  };
+
+  class Name final
+    : public mp::Helpers<Name>
+    , public mp::AllocatorHelper<mp::Helpers<Name>>
+  {
+  public:
+    using allocator_type = mp::Allocator;
+
+    std::pmr::string const &get_name() const { return name; }
+
+  private:
+    friend class mp::Helpers<Name>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string_view name
+      ) {
+        if (name.empty()) return on_fail(EmptyNameError{});
+        return on_success(mp::builder(constructor, name));
+      };
+    }
+
+    std::pmr::string name;
+
+  public:
+    Name(
+      typename mp::Helpers<Name>::Private
+    , std::allocator_arg_t, allocator_type const &allocator
+    , std::string_view name_
+    ) : name{name_, allocator}
+    {}
+  };
+
+  struct Plain {
+    int value;
+  };
+
+  // Declares an allocator but only has the plain constructor
+  class Label final
+    : public mp::Helpers<Label>
+    , public mp::AllocatorHelper<mp::Helpers<Label>>
+  {
+  public:
+    using allocator_type = mp::Allocator;
+
+    std::string const &get_text() const { return text; }
+
+  private:
+    friend class mp::Helpers<Label>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&&
+      , std::string_view text
+      ) {
+        return on_success(mp::builder(constructor, text));
+      };
+    }
+
+    std::string text;
+
+  public:
+    Label(typename mp::Helpers<Label>::Private, std::string_view text_)
+      : text{text_}
+    {}
+  };
+
+  class Service final
+    : public mp::Helpers<Service>
+    , public mp::AllocatorHelper<mp::Helpers<Service>>
+  {
+  public:
+    using allocator_type = mp::Allocator;
+
+    Name const &get_name() const { return name; }
+    std::pmr::string const &get_path() const { return path; }
+    Plain const &get_plain() const { return plain; }
+    std::pmr::map<std::pmr::string, int> const &get_limits() const {
+      return limits;
+    }
+
+  private:
+    friend class mp::Helpers<Service>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto name, auto path, auto plain, int port
+      ) {
+        if (port <= 0 || port > 65535) return on_fail(PortRangeError{});
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(name), std::move(path), std::move(plain))
+        , mp::arguments(port)
+        );
+      };
+    }
+
+    Name name;
+    std::pmr::string path;
+    Plain plain;
+    std::pmr::map<std::pmr::string, int> limits;
+
+  public:
+    template <typename N, typename P, typename L>
+    Service(
+      typename mp::Helpers<Service>::Private
+    , std::allocator_arg_t, allocator_type const &allocator
+    , int port
+    , N name_, P path_, L plain_
+    ) : name{std::move(name_).construct()}
+      , path{std::move(path_).construct()}
+      , plain{std::move(plain_).construct()}
+      , limits{allocator}
+    {
+      limits.emplace("a limit long enough to allocate", port);
+    }
+  };
+
+  auto service_builder(std::string_view name, int port) {
+    return Service::builder(
+      Name::builder(name)
+    , mp::allocator_wrapper<std::pmr::string>(
+        "a path that is long enough to allocate"
+      )
+    , mp::wrapper<Plain>(7)
+    , port
+    ).own();
+  }
+
+  bool uses(std::pmr::string const &string, std::pmr::memory_resource &r) {
+    return string.get_allocator().resource() == &r;
+  }
+}
+
+SCENARIO("allocator propagation") {
+  std::byte buffer[4096];
+  std::pmr::monotonic_buffer_resource monotonic{
+    buffer, sizeof(buffer), std::pmr::null_memory_resource()
+  };
+  CountingResource resource{monotonic};
+
+  WHEN("an aggregate is constructed with a resource") {
+    NoDefaultResource no_default;
+    bool all_in_resource = mp::with_resource(
+      resource, service_builder("service", 80)
+    ).construct(
+      [&](auto builder) {
+        auto service = std::move(builder).construct();
+        return uses(service.get_name().get_name(), resource)
+          && uses(service.get_path(), resource)
+          && service.get_limits().get_allocator().resource() == &resource
+          && uses(service.get_limits().begin()->first, resource)
+          && service.get_plain().value == 7;
+      }
+    , [](auto) { return false; }
+    );
+
+    THEN("every allocator-aware member, nested or wrapped, uses it") {
+      REQUIRE(all_in_resource);
+      REQUIRE(resource.allocations >= 3);
+    }
+
+    THEN("the resource is only current during construction") {
+      REQUIRE(mp::current_resource() == std::pmr::get_default_resource());
+    }
+  }
+
+  WHEN("an aggregate is constructed without a resource") {
+    bool uses_default = service_builder("service", 80).construct(
+      [&](auto builder) {
+        auto service = std::move(builder).construct();
+        return uses(
+          service.get_name().get_name(), *std::pmr::get_default_resource()
+        );
+      }
+    , [](auto) { return false; }
+    );
+
+    THEN("the default resource is used") {
+      REQUIRE(uses_default);
+      REQUIRE(resource.allocations == 0);
+    }
+  }
+
+  WHEN("a factory fails") {
+    std::string error = mp::with_resource(
+      resource, service_builder("", 80)
+    ).construct(
+      [](auto) { return std::string{}; }
+    , mp::handler(
+        [](EmptyNameError e) { return std::string{e.description}; }
+      , [](PortRangeError e) { return std::string{e.description}; }
+      )
+    );
+
+    THEN("nothing is allocated") {
+      REQUIRE(error == "Name is empty");
+      REQUIRE(resource.allocations == 0);
+    }
+  }
+
+  WHEN("resources are nested") {
+    std::pmr::unsynchronized_pool_resource inner;
+    std::pmr::memory_resource *seen = nullptr;
+    mp::with_resource(
+      resource
+    , mp::builder(
+        [&](auto&& on_success, auto&&) {
+          mp::with_resource(inner, Name::builder("inner")).construct(
+            [&](auto builder) {
+              seen = std::move(builder).construct()
+                .get_name().get_allocator().resource();
+            }
+          , [](auto) {}
+          );
+          return on_success(
+            mp::builder([] { return mp::current_resource(); })
+          );
+        }
+      )
+    ).construct(
+      [&](auto builder) {
+        REQUIRE(std::move(builder).construct() == &resource);
+      }
+    , [](auto) {}
+    );
+
+    THEN("the innermost one is used and the outer one is restored") {
+      REQUIRE(seen == &inner);
+    }
+  }
+
+  WHEN("the optional and variant helpers are used in a scope") {
+    NoDefaultResource no_default;
+    mp::ResourceScope scope{resource};
+    auto optional = Name::optional("optional").construct([](auto) {});
+    auto variant = Name::variant<EmptyNameError>("variant");
+
+    THEN("they use the resource too") {
+      REQUIRE(uses(optional->get_name(), resource));
+      REQUIRE(uses(std::get<Name>(variant).get_name(), resource));
+    }
+  }
+
+  WHEN("a wrapped container is constructed") {
+    auto outside = mp::allocator_wrapper<std::pmr::vector<int>>(3, 4).construct(
+      [](auto builder) { return std::move(builder).construct(); }
+    , [](auto) { return std::pmr::vector<int>{}; }
+    );
+    auto inside = mp::with_resource(
+      resource, mp::allocator_wrapper<std::pmr::vector<int>>(3, 4)
+    ).construct(
+      [](auto builder) { return std::move(builder).construct(); }
+    , [](auto) { return std::pmr::vector<int>{}; }
+    );
+    auto plain = mp::with_resource(
+      resource, mp::wrapper<std::pmr::vector<int>>(3, 4)
+    ).construct(
+      [](auto builder) { return std::move(builder).construct(); }
+    , [](auto) { return std::pmr::vector<int>{}; }
+    );
+
+    THEN("braces keep their meaning and only the scope adds the resource") {
+      REQUIRE(outside == std::pmr::vector<int>{3, 4});
+      REQUIRE(
+        outside.get_allocator().resource() == std::pmr::get_default_resource()
+      );
+      REQUIRE(inside == std::pmr::vector<int>{3, 4});
+      REQUIRE(inside.get_allocator().resource() == &resource);
+    }
+
+    THEN("a plain wrapper doesn't opt in") {
+      REQUIRE(plain == std::pmr::vector<int>{3, 4});
+      REQUIRE(
+        plain.get_allocator().resource() == std::pmr::get_default_resource()
+      );
+    }
+  }
+
+  WHEN("a type declares an allocator without taking one") {
+    auto outside = Label::builder("outside").construct(
+      [](auto builder) { return std::move(builder).construct().get_text(); }
+    , [](auto) { return std::string{}; }
+    );
+    auto inside = mp::with_resource(resource, Label::builder("inside"))
+      .construct(
+        [](auto builder) { return std::move(builder).construct().get_text(); }
+      , [](auto) { return std::string{}; }
+      );
+
+    THEN("its plain constructor is used") {
+      REQUIRE(outside == "outside");
+      REQUIRE(inside == "inside");
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,235 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/any_builder.hpp>
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct UnknownCodecError {
+    static constexpr auto description = "Unknown codec";
+  };
+
+  struct InvalidLevelError {
+    static constexpr auto description = "Compression level is out of range";
+  };
+
+  class Codec final : public mp::Helpers<Codec> {
+  public:
+    std::string const &get_name() const { return name; }
+    int get_level() const { return level; }
+
+  private:
+    friend class mp::Helpers<Codec>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name, int level
+      ) {
+        if (name != "gzip" && name != "none") {
+          return on_fail(UnknownCodecError{});
+        }
+        if (level < 0 || level > 9) return on_fail(InvalidLevelError{});
+        return on_success(mp::builder(constructor, std::move(name), level));
+      };
+    }
+
+    std::string name;
+    int level;
+
+  public:
+    Codec(typename mp::Helpers<Codec>::Private, std::string name_, int level_)
+      : name{std::move(name_)}, level{level_}
+    {}
+  };
+
+  using AnyCodec = mp::AnyBuilder<Codec, UnknownCodecError, InvalidLevelError>;
+
+  // Each branch returns a builder of a different type
+  AnyCodec choose_codec(std::string const &config) {
+    if (config.empty()) return AnyCodec{Codec::builder("none", 0)};
+    if (config == "fast") {
+      return AnyCodec{Codec::builder(std::string{"gzip"}, 1)};
+    }
+    return AnyCodec{Codec::builder(config, 6)};
+  }
+
+  class Pipeline final : public mp::Helpers<Pipeline> {
+  public:
+    Codec const &get_input() const { return input; }
+    Codec const &get_output() const { return output; }
+
+  private:
+    friend class mp::Helpers<Pipeline>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , AnyCodec input, AnyCodec output
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(input), std::move(output))
+        );
+      };
+    }
+
+    Codec input;
+    Codec output;
+
+  public:
+    Pipeline(
+      typename mp::Helpers<Pipeline>::Private
+    , mp::AnyPostBuilder<Codec> input_
+    , mp::AnyPostBuilder<Codec> output_
+    ) : input{std::move(input_).construct()}
+      , output{std::move(output_).construct()}
+    {}
+  };
+
+  auto describe = mp::handler(
+    [](UnknownCodecError e) { return std::string{e.description}; }
+  , [](InvalidLevelError e) { return std::string{e.description}; }
+  );
+
+  std::string summarize(AnyCodec codec) {
+    return std::move(codec).construct(
+      [](auto builder) {
+        auto codec = std::move(builder).construct();
+        return codec.get_name() + ":" + std::to_string(codec.get_level());
+      }
+    , describe
+    );
+  }
+
+  struct Blob {
+    std::shared_ptr<int> tracker;
+    std::array<char, 256> bytes;
+  };
+
+  auto make_blob = [](std::shared_ptr<int> tracker, char fill) {
+    Blob blob{std::move(tracker), {}};
+    blob.bytes.fill(fill);
+    return blob;
+  };
+}
+
+SCENARIO("type-erased builders") {
+  WHEN("the builder is chosen at runtime") {
+    auto fast = summarize(choose_codec("fast"));
+    auto none = summarize(choose_codec(""));
+    auto zip = summarize(choose_codec("gzip"));
+    auto bad = summarize(choose_codec("lz4"));
+
+    THEN("each one runs its own factory") {
+      REQUIRE(fast == "gzip:1");
+      REQUIRE(none == "none:0");
+      REQUIRE(zip == "gzip:6");
+      REQUIRE(bad == std::string{UnknownCodecError::description});
+    }
+  }
+
+  WHEN("type-erased builders are nested") {
+    auto run = [](std::string const &in, std::string const &out) {
+      return Pipeline::builder(choose_codec(in), choose_codec(out)).construct(
+        [](auto builder) {
+          auto pipeline = std::move(builder).construct();
+          return pipeline.get_input().get_name()
+            + "->" + pipeline.get_output().get_name();
+        }
+      , describe
+      );
+    };
+
+    THEN("they compose like any other builder") {
+      REQUIRE(run("fast", "") == "gzip->none");
+      std::string error = UnknownCodecError::description;
+      REQUIRE(run("", "brotli") == error);
+    }
+  }
+
+  WHEN("the error set is handled") {
+    AnyCodec codec{Codec::builder("gzip", 12)};
+
+    THEN("errors are reported as their own type") {
+      std::string error = InvalidLevelError::description;
+      REQUIRE(summarize(std::move(codec)) == error);
+    }
+  }
+
+  WHEN("an AnyBuilder is default constructed or moved from") {
+    AnyCodec empty;
+    AnyCodec source{Codec::builder("gzip", 1)};
+    AnyCodec target{std::move(source)};
+
+    THEN("it is empty until it is assigned a builder") {
+      REQUIRE(!empty);
+      REQUIRE(!source);
+      REQUIRE(target);
+      empty = std::move(target);
+      REQUIRE(summarize(std::move(empty)) == "gzip:1");
+    }
+  }
+
+  WHEN("builders don't convert implicitly") {
+    THEN("erasing one is spelled out") {
+      using Builder = decltype(Codec::builder("gzip", 1));
+      REQUIRE(!std::is_convertible<Builder, AnyCodec>::value);
+      REQUIRE(std::is_constructible<AnyCodec, Builder>::value);
+    }
+  }
+
+  WHEN("the builder is small") {
+    auto builder = Codec::builder(std::string{"gzip"}, 1);
+
+    THEN("it is stored inline") {
+      REQUIRE(AnyCodec::fits_inline<decltype(std::move(builder).own())>());
+    }
+  }
+
+  WHEN("the builder is large") {
+    using AnyBlob = mp::AnyBuilder<Blob>;
+    auto tracker = std::make_shared<int>(0);
+    Blob blob = {nullptr, {}};
+    {
+      AnyBlob first{mp::builder(mp::factory<Blob>, make_blob(tracker, 'x'))};
+      AnyBlob second{std::move(first)};
+      AnyBlob third{mp::builder(mp::factory<Blob>, make_blob(tracker, 'y'))};
+      third = std::move(second);
+      REQUIRE(tracker.use_count() == 2);
+      std::move(third).construct(
+        [&](auto builder) { blob = std::move(builder).construct(); }
+      , [](auto) {}
+      );
+    }
+
+    THEN("it is stored on the heap and still owned") {
+      REQUIRE(
+        !AnyBlob::fits_inline<
+          decltype(mp::builder(mp::factory<Blob>, std::declval<Blob>()).own())
+        >()
+      );
+      REQUIRE(blob.bytes[255] == 'x');
+      REQUIRE(tracker.use_count() == 2);
+    }
+  }
+}
@@ -0,0 +1,187 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/arena.hpp>
+#include <mz/piecewise/construct_helpers.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  std::vector<std::string> destroyed;
+
+  struct EmptyError {
+    static constexpr auto description = "Name is empty";
+  };
+
+  class Leaf final
+    : public mp::Helpers<Leaf>
+    , public mp::ArenaHelper<mp::Helpers<Leaf>>
+  {
+  public:
+    std::string const &get_name() const { return name; }
+
+    ~Leaf() { destroyed.push_back(name); }
+
+  private:
+    friend class mp::Helpers<Leaf>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name
+      ) {
+        if (name.empty()) return on_fail(EmptyError{});
+        return on_success(mp::builder(constructor, std::move(name)));
+      };
+    }
+
+    std::string name;
+
+  public:
+    Leaf(typename mp::Helpers<Leaf>::Private, std::string name_)
+      : name{std::move(name_)}
+    {}
+  };
+
+  // Members that would otherwise be `std::unique_ptr`s
+  class Node final
+    : public mp::Helpers<Node>
+    , public mp::ArenaHelper<mp::Helpers<Node>>
+  {
+  public:
+    Leaf const &get_left() const { return *left; }
+    Leaf const &get_right() const { return *right; }
+    mp::ArenaPtr<Leaf> get_left_pointer() const { return left; }
+    mp::ArenaPtr<Leaf> get_right_pointer() const { return right; }
+
+    ~Node() { destroyed.push_back("node"); }
+
+  private:
+    friend class mp::Helpers<Node>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto left, auto right
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(left), std::move(right))
+        );
+      };
+    }
+
+    mp::ArenaPtr<Leaf> left;
+    mp::ArenaPtr<Leaf> right;
+
+  public:
+    template <typename L, typename R>
+    Node(
+      typename mp::Helpers<Node>::Private
+    , mp::Arena &arena
+    , L left_, R right_
+    ) : left{arena.construct(std::move(left_))}
+      , right{arena.construct(std::move(right_))}
+    {}
+  };
+
+  struct alignas(64) Aligned {
+    char byte;
+  };
+
+  std::uintptr_t address(void const *pointer) {
+    return reinterpret_cast<std::uintptr_t>(pointer);
+  }
+}
+
+SCENARIO("arena placement") {
+  destroyed.clear();
+
+  WHEN("an object graph is placed in an arena") {
+    auto arena = std::make_unique<mp::Arena>();
+    auto node = Node::arena(
+      *arena, Leaf::builder("left"), Leaf::builder("right")
+    ).construct([](auto) {});
+
+    THEN("the objects are laid out in construction order") {
+      REQUIRE(node);
+      REQUIRE(node->get_left().get_name() == "left");
+      REQUIRE(node->get_right().get_name() == "right");
+      auto left = node->get_left_pointer().get();
+      auto right = node->get_right_pointer().get();
+      REQUIRE(address(node.get()) < address(left));
+      REQUIRE(address(left) < address(right));
+      REQUIRE(address(right) - address(node.get()) < 256);
+    }
+
+    THEN("releasing the arena destroys owners before their members") {
+      arena.reset();
+      REQUIRE(destroyed == std::vector<std::string>{"node", "right", "left"});
+    }
+  }
+
+  WHEN("a nested factory fails") {
+    mp::Arena arena;
+    std::string error;
+    auto node = Node::arena(
+      arena, Leaf::builder("left"), Leaf::builder("")
+    ).construct([&](auto e) { error = e.description; });
+
+    THEN("nothing is placed") {
+      REQUIRE(!node);
+      REQUIRE(error == std::string{EmptyError::description});
+    }
+  }
+
+  WHEN("a type without an arena constructor is placed") {
+    mp::Arena arena;
+    auto leaf = Leaf::arena(arena, "leaf").construct([](auto) {});
+
+    THEN("it is constructed as usual") {
+      REQUIRE(leaf);
+      REQUIRE(leaf->get_name() == "leaf");
+    }
+  }
+
+  WHEN("objects don't fit in one block") {
+    mp::Arena arena{64};
+    std::vector<mp::ArenaPtr<Leaf>> leaves;
+    for (int i = 0; i < 16; ++i) {
+      leaves.push_back(
+        Leaf::arena(arena, std::to_string(i)).construct([](auto) {})
+      );
+    }
+    auto aligned = arena.construct(
+      mp::builder(mp::braced_construct<Aligned>, 'x')
+    );
+
+    THEN("new blocks are added as needed") {
+      for (int i = 0; i < 16; ++i) {
+        REQUIRE(leaves[i]->get_name() == std::to_string(i));
+      }
+      REQUIRE(aligned->byte == 'x');
+      REQUIRE(address(aligned.get()) % 64 == 0);
+    }
+
+    THEN("release destroys everything") {
+      arena.release();
+      REQUIRE(destroyed.size() == 16);
+      REQUIRE(destroyed.front() == "15");
+    }
+  }
+}
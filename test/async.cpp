@@ -0,0 +1,298 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail_async.hpp>
+#include <mz/piecewise/task.hpp>
+
+#if defined(MZ_PIECEWISE_COROUTINES)
+
+#include <coroutine>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  // A single threaded event loop. Coroutines that yield go to the back of
+  // the queue, so concurrently running constructions interleave.
+  class EventLoop {
+  public:
+    struct Yield {
+      EventLoop &loop;
+
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> handle) const {
+        loop.ready.push_back(handle);
+      }
+      void await_resume() const noexcept {}
+    };
+
+    Yield yield() { return {*this}; }
+
+    void run() {
+      while (!ready.empty()) {
+        auto handle = ready.front();
+        ready.pop_front();
+        handle.resume();
+      }
+    }
+
+  private:
+    std::deque<std::coroutine_handle<>> ready;
+  };
+
+  EventLoop loop;
+  std::vector<std::string> events;
+
+  struct UnreachableError {
+    static constexpr auto description = "Host is unreachable";
+  };
+
+  // Pretends to wait for the network for `latency` turns of the event loop
+  class Connection final : public mp::Helpers<Connection> {
+  public:
+    std::string const &get_host() const { return host; }
+
+  private:
+    friend class mp::Helpers<Connection>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string host, int latency
+      ) -> mp::Task<> {
+        events.push_back(host + " connecting");
+        for (int i = 0; i < latency; ++i) co_await loop.yield();
+        events.push_back(host + " connected");
+        if (latency < 0) co_return co_await on_fail(UnreachableError{});
+        co_return co_await on_success(mp::builder(constructor, host));
+      };
+    }
+
+    std::string host;
+
+  public:
+    Connection(typename mp::Helpers<Connection>::Private, std::string host_)
+      : host{std::move(host_)}
+    {}
+  };
+
+  struct NegativeError {
+    static constexpr auto description = "Size is negative";
+  };
+
+  // An ordinary synchronous factory works with `construct_async` too
+  class Cache final : public mp::Helpers<Cache> {
+  public:
+    int get_size() const { return size; }
+
+  private:
+    friend class mp::Helpers<Cache>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int size
+      ) {
+        if (size < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, size));
+      };
+    }
+
+    int size;
+
+  public:
+    Cache(typename mp::Helpers<Cache>::Private, int size_) : size{size_} {}
+  };
+
+  struct Credentials {
+    std::string user;
+  };
+
+  class Service final : public mp::Helpers<Service> {
+  public:
+    std::string describe() const {
+      return credentials.user + "@" + primary.get_host()
+        + "," + replica.get_host()
+        + " cache=" + std::to_string(cache.get_size())
+        + " " + name;
+    }
+
+  private:
+    friend class mp::Helpers<Service>;
+
+    // Synchronous itself, so everything it passes on has to outlive it
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name
+      , auto primary, auto replica, auto cache
+      ) {
+        return mp::multifail_async(
+          constructor
+        , on_success, on_fail
+        , mp::builders(
+            std::move(primary), std::move(replica), std::move(cache)
+          , mp::wrapper<Credentials>(name + "-user")
+          )
+        , mp::arguments(name)
+        );
+      };
+    }
+
+    std::string name;
+    Connection primary;
+    Connection replica;
+    Cache cache;
+    Credentials credentials;
+
+  public:
+    template <typename P, typename R, typename C, typename U>
+    Service(
+      typename mp::Helpers<Service>::Private
+    , std::string name_
+    , P primary_, R replica_, C cache_, U credentials_
+    ) : name{std::move(name_)}
+      , primary{std::move(primary_).construct()}
+      , replica{std::move(replica_).construct()}
+      , cache{std::move(cache_).construct()}
+      , credentials{std::move(credentials_).construct()}
+    {}
+  };
+
+  template <typename T>
+  T run(mp::Task<T> task) {
+    task.start();
+    loop.run();
+    REQUIRE(task.done());
+    return task.get();
+  }
+
+  auto describe() {
+    return [](auto builder) {
+      return std::move(builder).construct().describe();
+    };
+  }
+
+  auto error_description() {
+    return mp::handler(
+      [](UnreachableError e) { return std::string{e.description}; }
+    , [](NegativeError e) { return std::string{e.description}; }
+    );
+  }
+}
+
+SCENARIO("async construction") {
+  events.clear();
+
+  WHEN("a factory suspends") {
+    auto task = mp::construct_async<std::string>(
+      Connection::builder("db", 2)
+    , [](auto builder) { return std::move(builder).construct().get_host(); }
+    , error_description()
+    );
+
+    THEN("nothing happens until the task runs") {
+      REQUIRE(events.empty());
+      REQUIRE(run(std::move(task)) == "db");
+      REQUIRE(events == std::vector<std::string>{
+        "db connecting", "db connected"
+      });
+    }
+  }
+
+  WHEN("a factory fails after suspending") {
+    auto result = run(
+      mp::construct_async<std::string>(
+        Connection::builder("nowhere", -1)
+      , [](auto) { return std::string{"success"}; }
+      , error_description()
+      )
+    );
+
+    THEN("the failure callback yields the result") {
+      REQUIRE(result == UnreachableError::description);
+    }
+  }
+
+  WHEN("nested builders are constructed with multifail_async") {
+    auto result = run(
+      mp::construct_async<std::string>(
+        Service::builder(
+          std::string{"orders"}
+        , Connection::builder("primary", 1)
+        , Connection::builder("replica", 3)
+        , Cache::builder(64)
+        )
+      , describe(), error_description()
+      )
+    );
+
+    THEN("the aggregate owns everything it was built from") {
+      REQUIRE(result == "orders-user@primary,replica cache=64 orders");
+    }
+  }
+
+  WHEN("a nested synchronous factory fails") {
+    auto result = run(
+      mp::construct_async<std::string>(
+        Service::builder(
+          std::string{"orders"}
+        , Connection::builder("primary", 1)
+        , Connection::builder("replica", 1)
+        , Cache::builder(-1)
+        )
+      , describe(), error_description()
+      )
+    );
+
+    THEN("the asynchronous factories before it still ran") {
+      REQUIRE(result == NegativeError::description);
+      REQUIRE(events.size() == 4);
+    }
+  }
+
+  WHEN("several constructions share one event loop") {
+    auto first = mp::construct_async<std::string>(
+      Service::builder(
+        std::string{"a"}
+      , Connection::builder("a1", 2)
+      , Connection::builder("a2", 1)
+      , Cache::builder(1)
+      )
+    , describe(), error_description()
+    );
+    auto second = mp::construct_async<std::string>(
+      Connection::builder("b1", 1)
+    , [](auto builder) { return std::move(builder).construct().get_host(); }
+    , error_description()
+    );
+    first.start();
+    second.start();
+    loop.run();
+
+    THEN("their factories interleave") {
+      REQUIRE(first.get() == "a-user@a1,a2 cache=1 a");
+      REQUIRE(second.get() == "b1");
+      REQUIRE(events == std::vector<std::string>{
+        "a1 connecting", "b1 connecting"
+      , "b1 connected", "a1 connected"
+      , "a2 connecting", "a2 connected"
+      });
+    }
+  }
+}
+
+#endif
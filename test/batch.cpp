@@ -0,0 +1,221 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/batch.hpp>
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/parallel_multifail.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  int moves = 0;
+
+  struct EmptyPathError {
+    static constexpr auto description = "Path is empty";
+  };
+
+  struct InvalidPortError {
+    static constexpr auto description = "Port is out of range";
+  };
+
+  class Route final
+    : public mp::Helpers<Route>
+    , public mp::BatchHelper<mp::Helpers<Route>>
+  {
+  public:
+    std::string const &get_path() const { return path; }
+    int get_port() const { return port; }
+
+    Route(Route const &) = default;
+    Route(Route &&other)
+      : path{std::move(other.path)}, port{other.port}
+    { ++moves; }
+
+  private:
+    friend class mp::Helpers<Route>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string path, int port
+      ) {
+        if (path.empty()) return on_fail(EmptyPathError{});
+        if (port <= 0 || port > 65535) return on_fail(InvalidPortError{});
+        return on_success(mp::builder(constructor, std::move(path), port));
+      };
+    }
+
+    std::string path;
+    int port;
+
+  public:
+    Route(typename mp::Helpers<Route>::Private, std::string path_, int port_)
+      : path{std::move(path_)}, port{port_}
+    {
+      if (path == "/throw") throw std::runtime_error{"throw"};
+    }
+  };
+
+  using Failure = std::pair<std::size_t, std::string>;
+
+  auto record(std::vector<Failure> &failures) {
+    return mp::handler(
+      [&](std::size_t row, EmptyPathError e) {
+        failures.emplace_back(row, std::string{e.description});
+      }
+    , [&](std::size_t row, InvalidPortError e) {
+        failures.emplace_back(row, std::string{e.description});
+      }
+    );
+  }
+
+  std::vector<std::tuple<std::string, int>> make_rows(int count) {
+    std::vector<std::tuple<std::string, int>> rows;
+    for (int i = 0; i < count; ++i) {
+      if (i % 10 == 3) {
+        rows.emplace_back("", 80);
+      } else if (i % 10 == 7) {
+        rows.emplace_back("/bad", -1);
+      } else {
+        rows.emplace_back("/route" + std::to_string(i), 1000 + i);
+      }
+    }
+    return rows;
+  }
+
+  void check(
+    std::vector<Route> const &routes
+  , std::vector<Failure> failures
+  , int count
+  ) {
+    std::sort(failures.begin(), failures.end());
+    std::size_t next_route = 0;
+    std::size_t next_failure = 0;
+    for (int i = 0; i < count; ++i) {
+      auto row = static_cast<std::size_t>(i);
+      if (i % 10 == 3 || i % 10 == 7) {
+        REQUIRE(failures.at(next_failure).first == row);
+        std::string expected = i % 10 == 3
+          ? EmptyPathError::description
+          : InvalidPortError::description;
+        REQUIRE(failures.at(next_failure).second == expected);
+        ++next_failure;
+      } else {
+        auto const &route = routes.at(next_route);
+        REQUIRE(route.get_path() == "/route" + std::to_string(i));
+        REQUIRE(route.get_port() == 1000 + i);
+        ++next_route;
+      }
+    }
+    REQUIRE(next_route == routes.size());
+    REQUIRE(next_failure == failures.size());
+  }
+
+  // Never runs anything itself, so the calling thread has to do all the work
+  struct DeferredExecutor {
+    std::vector<std::function<void()>> tasks;
+
+    void operator()(std::function<void()> task) {
+      tasks.push_back(std::move(task));
+    }
+  };
+}
+
+SCENARIO("batch construction") {
+  moves = 0;
+  auto rows = make_rows(100);
+  std::vector<Failure> failures;
+
+  WHEN("rows are constructed sequentially") {
+    auto routes = Route::batch(rows, record(failures));
+
+    THEN("valid rows are constructed in order and failures are reported") {
+      check(routes, failures, 100);
+      REQUIRE(routes.size() == 80);
+      REQUIRE(failures.size() == 20);
+    }
+
+    THEN("the instances are constructed in place") {
+      REQUIRE(moves == 0);
+      REQUIRE(routes.capacity() >= rows.size());
+    }
+  }
+
+  WHEN("rows are constructed on several threads") {
+    mp::ThreadExecutor executor;
+    auto routes = mp::construct_batch<Route>(
+      executor
+    , rows
+    , [](auto const&... args) { return Route::builder(args...); }
+    , record(failures)
+    , 4
+    );
+
+    THEN("the result is the same") {
+      check(routes, failures, 100);
+    }
+  }
+
+  WHEN("the executor never runs its tasks") {
+    DeferredExecutor executor;
+    auto routes = Route::batch(executor, rows, record(failures));
+
+    THEN("the calling thread constructs every chunk") {
+      check(routes, failures, 100);
+    }
+
+    THEN("tasks that run late do nothing") {
+      for (auto &task : executor.tasks) task();
+      REQUIRE(routes.size() == 80);
+    }
+  }
+
+  WHEN("there are no rows") {
+    mp::ThreadExecutor executor;
+    std::vector<std::tuple<std::string, int>> none;
+    auto routes = Route::batch(executor, none, record(failures));
+
+    THEN("nothing is constructed") {
+      REQUIRE(routes.empty());
+      REQUIRE(failures.empty());
+    }
+  }
+
+  WHEN("a row throws on one of several threads") {
+    rows[50] = std::make_tuple(std::string{"/throw"}, 80);
+    bool thrown = false;
+    {
+      mp::ThreadExecutor executor;
+      try {
+        mp::construct_batch<Route>(
+          executor
+        , rows
+        , [](auto const&... args) { return Route::builder(args...); }
+        , record(failures)
+        , 4
+        );
+      } catch (std::runtime_error const &) {
+        thrown = true;
+      }
+    }
+
+    THEN("the exception reaches the caller once every chunk is done") {
+      REQUIRE(thrown);
+    }
+  }
+}
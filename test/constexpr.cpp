@@ -0,0 +1,216 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+
+#if __cplusplus >= 201703L
+
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/construct_helpers.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <string_view>
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct EmptyHostError {
+    static constexpr auto description = "Host is empty";
+  };
+
+  struct PortRangeError {
+    static constexpr auto description = "Port is out of range";
+  };
+
+  class Host final : public mp::Helpers<Host> {
+  public:
+    constexpr std::string_view get_name() const { return name; }
+
+  private:
+    friend class mp::Helpers<Host>;
+
+    static constexpr auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string_view name
+      ) {
+        if (name.empty()) return on_fail(EmptyHostError{});
+        return on_success(mp::builder(constructor, name));
+      };
+    }
+
+    std::string_view name;
+
+  public:
+    constexpr Host(typename mp::Helpers<Host>::Private, std::string_view name_)
+      : name{name_}
+    {}
+  };
+
+  class Port final : public mp::Helpers<Port> {
+  public:
+    constexpr int get_number() const { return number; }
+
+  private:
+    friend class mp::Helpers<Port>;
+
+    static constexpr auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int number
+      ) {
+        if (number <= 0 || number > 65535) return on_fail(PortRangeError{});
+        return on_success(mp::builder(constructor, number));
+      };
+    }
+
+    int number;
+
+  public:
+    constexpr Port(typename mp::Helpers<Port>::Private, int number_)
+      : number{number_}
+    {}
+  };
+
+  class Endpoint final : public mp::Helpers<Endpoint> {
+  public:
+    constexpr Host const &get_host() const { return host; }
+    constexpr Port const &get_port() const { return port; }
+    constexpr int get_retries() const { return retries; }
+
+  private:
+    friend class mp::Helpers<Endpoint>;
+
+    static constexpr auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto host, auto port, int retries
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(host), std::move(port))
+        , mp::arguments(retries)
+        );
+      };
+    }
+
+    int retries;
+    Host host;
+    Port port;
+
+  public:
+    template <typename H, typename P>
+    constexpr Endpoint(
+      typename mp::Helpers<Endpoint>::Private
+    , int retries_, H host_, P port_
+    ) : retries{retries_}
+      , host{std::move(host_).construct()}
+      , port{std::move(port_).construct()}
+    {}
+  };
+
+  struct Point {
+    int x;
+    int y;
+  };
+
+  // Validated during compilation. Changing the port to 0 makes this a compile
+  // error that names `PortRangeError`.
+  constexpr Endpoint endpoint = Endpoint::constant(
+    Host::builder("localhost"), Port::builder(8080), 3
+  );
+
+  constexpr auto number_of = [](auto builder) {
+    return std::move(builder).construct(
+      [](auto post) { return std::move(post).construct().get_number(); }
+    , mp::handler(
+        [](PortRangeError) { return -1; }
+      , [](auto) { return -2; }
+      )
+    );
+  };
+}
+
+SCENARIO("constant expressions") {
+  WHEN("an aggregate is constructed at compile time") {
+    static_assert(endpoint.get_host().get_name() == "localhost");
+    static_assert(endpoint.get_port().get_number() == 8080);
+    static_assert(endpoint.get_retries() == 3);
+
+    THEN("it is a constant") {
+      REQUIRE(endpoint.get_port().get_number() == 8080);
+    }
+  }
+
+  WHEN("builders are constructed with callbacks") {
+    constexpr int good = number_of(Port::builder(443));
+    constexpr int bad = number_of(Port::builder(0));
+
+    THEN("both the success and failure paths are constant") {
+      static_assert(good == 443);
+      static_assert(bad == -1);
+      REQUIRE(good == 443);
+      REQUIRE(bad == -1);
+    }
+  }
+
+  WHEN("a nested factory fails") {
+    constexpr auto failed = Endpoint::builder(
+      Host::builder(""), Port::builder(80), 0
+    ).construct(
+      [](auto) { return false; }
+    , mp::handler(
+        [](EmptyHostError) { return true; }
+      , [](auto) { return false; }
+      )
+    );
+
+    THEN("multifail reports it during constant evaluation") {
+      static_assert(failed);
+      REQUIRE(failed);
+    }
+  }
+
+  WHEN("builders are ordered by cost") {
+    constexpr Endpoint reordered = Endpoint::constant(
+      mp::cost<1>(Host::builder("example.com")), Port::builder(8443), 5
+    );
+
+    THEN("the constructor still receives them in declared order") {
+      static_assert(reordered.get_host().get_name() == "example.com");
+      static_assert(reordered.get_port().get_number() == 8443);
+      REQUIRE(reordered.get_retries() == 5);
+    }
+  }
+
+  WHEN("plain types and the other helpers are used") {
+    constexpr Point point = mp::braced_construct<Point>(1, 2);
+    constexpr auto wrapped = mp::wrapper<Point>(3, 4).construct(
+      [](auto builder) { return std::move(builder).construct(); }
+    , [](auto) { return Point{0, 0}; }
+    );
+    constexpr auto variant = Port::variant<PortRangeError>(22);
+    constexpr auto optional = Port::optional(70000).construct([](auto) {});
+
+    THEN("they are constants too") {
+      static_assert(point.x == 1 && point.y == 2);
+      static_assert(wrapped.x == 3 && wrapped.y == 4);
+      static_assert(std::get<Port>(variant).get_number() == 22);
+      static_assert(!optional.has_value());
+      REQUIRE(point.y == 2);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,259 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  std::vector<std::string> factory_runs;
+
+  struct NegativeError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  struct MissingFileError {
+    static constexpr auto description = "File is missing";
+  };
+
+  // Cheap to validate
+  class Count final : public mp::Helpers<Count> {
+  public:
+    int get_count() const { return count; }
+
+  private:
+    friend class mp::Helpers<Count>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int count
+      ) {
+        factory_runs.push_back("count " + std::to_string(count));
+        if (count < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, count));
+      };
+    }
+
+    int count;
+
+  public:
+    Count(typename mp::Helpers<Count>::Private, int count_)
+      : count{count_}
+    {}
+  };
+
+  // Stands in for a factory that opens a file
+  class File final : public mp::Helpers<File> {
+  public:
+    std::string const &get_path() const { return path; }
+
+  private:
+    friend class mp::Helpers<File>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string path
+      ) {
+        factory_runs.push_back("file " + path);
+        if (path.empty()) return on_fail(MissingFileError{});
+        return on_success(mp::builder(constructor, std::move(path)));
+      };
+    }
+
+    std::string path;
+
+  public:
+    File(typename mp::Helpers<File>::Private, std::string path_)
+      : path{std::move(path_)}
+    {}
+  };
+
+  struct Label {
+    std::string text;
+  };
+
+  class Config final : public mp::Helpers<Config> {
+  public:
+    File const &get_file() const { return file; }
+    Count const &get_first() const { return first; }
+    Count const &get_second() const { return second; }
+    Label const &get_label() const { return label; }
+    int get_version() const { return version; }
+
+  private:
+    friend class mp::Helpers<Config>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto file, auto first, auto second, auto label, int version
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(
+            std::move(file), std::move(first), std::move(second)
+          , std::move(label)
+          )
+        , mp::arguments(version)
+        );
+      };
+    }
+
+    int version;
+    File file;
+    Count first;
+    Count second;
+    Label label;
+
+  public:
+    template <typename F, typename C1, typename C2, typename L>
+    Config(
+      typename mp::Helpers<Config>::Private
+    , int version_
+    , F file_, C1 first_, C2 second_, L label_
+    ) : version{version_}
+      , file{std::move(file_).construct()}
+      , first{std::move(first_).construct()}
+      , second{std::move(second_).construct()}
+      , label{std::move(label_).construct()}
+    {}
+  };
+
+  template <typename FileBuilder>
+  std::string construct(FileBuilder file, int first, int second) {
+    return Config::builder(
+      std::move(file)
+    , Count::builder(first)
+    , Count::builder(second)
+    , mp::wrapper<Label>("label")
+    , 3
+    ).construct(
+      [](auto builder) {
+        auto config = std::move(builder).construct();
+        return config.get_file().get_path() + " "
+          + std::to_string(config.get_first().get_count()) + " "
+          + std::to_string(config.get_second().get_count()) + " "
+          + config.get_label().text + " "
+          + std::to_string(config.get_version());
+      }
+    , mp::handler(
+        [](NegativeError e) { return std::string{e.description}; }
+      , [](MissingFileError e) { return std::string{e.description}; }
+      )
+    );
+  }
+}
+
+SCENARIO("cost ordered multifail") {
+  factory_runs.clear();
+
+  GIVEN("an expensive builder declared first") {
+    WHEN("it is not tagged") {
+      auto result = construct(File::builder("a.conf"), 1, 2);
+
+      THEN("factories run in declared order") {
+        REQUIRE(result == "a.conf 1 2 label 3");
+        REQUIRE(factory_runs == std::vector<std::string>{
+          "file a.conf", "count 1", "count 2"
+        });
+      }
+    }
+
+    WHEN("it is tagged with a cost and everything succeeds") {
+      auto result = construct(mp::cost<10>(File::builder("a.conf")), 1, 2);
+
+      THEN("it runs last") {
+        REQUIRE(factory_runs == std::vector<std::string>{
+          "count 1", "count 2", "file a.conf"
+        });
+      }
+
+      THEN("the constructor receives the builders in declared order") {
+        REQUIRE(result == "a.conf 1 2 label 3");
+      }
+    }
+
+    WHEN("it is tagged with a cost and a cheap check fails") {
+      auto result = construct(mp::cost<10>(File::builder("a.conf")), 1, -2);
+
+      THEN("it never runs") {
+        REQUIRE(result == "Value is negative");
+        REQUIRE(factory_runs == std::vector<std::string>{
+          "count 1", "count -2"
+        });
+      }
+    }
+
+    WHEN("it fails itself") {
+      auto result = construct(mp::cost<10>(File::builder("")), 1, 2);
+
+      THEN("its error is reported after the cheap checks passed") {
+        REQUIRE(result == "File is missing");
+        REQUIRE(factory_runs == std::vector<std::string>{
+          "count 1", "count 2", "file "
+        });
+      }
+    }
+  }
+
+  GIVEN("a cheap check declared last") {
+    WHEN("it is tagged with a negative cost") {
+      auto result = Config::builder(
+        File::builder("b.conf")
+      , Count::builder(1)
+      , mp::cost<-1>(Count::builder(-2))
+      , mp::wrapper<Label>("label")
+      , 3
+      ).construct(
+        [](auto) { return std::string{}; }
+      , [](auto e) { return std::string{e.description}; }
+      );
+
+      THEN("it runs before the untagged builders") {
+        REQUIRE(result == "Value is negative");
+        REQUIRE(factory_runs == std::vector<std::string>{"count -2"});
+      }
+    }
+  }
+
+  GIVEN("builders with equal costs") {
+    auto result = Config::builder(
+      mp::cost<5>(File::builder("c.conf"))
+    , mp::cost<5>(Count::builder(1))
+    , mp::cost<1>(Count::builder(2))
+    , mp::wrapper<Label>("label")
+    , 3
+    ).construct(
+      [](auto builder) {
+        auto config = std::move(builder).construct();
+        return config.get_second().get_count();
+      }
+    , [](auto) { return -1; }
+    );
+
+    THEN("they run in declared order") {
+      REQUIRE(result == 2);
+      REQUIRE(factory_runs == std::vector<std::string>{
+        "count 2", "file c.conf", "count 1"
+      });
+    }
+  }
+}
@@ -0,0 +1,261 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/deadline.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  int handshakes = 0;
+  int disks_mounted = 0;
+
+  struct RefusedError {
+    static constexpr auto description = "Connection refused";
+  };
+
+  struct NoDiskError {
+    static constexpr auto description = "Disk isn't mounted";
+  };
+
+  // Fails until it has been attempted `refusals` times. The handshake takes
+  // `latency`, unless the deadline is closer.
+  class Connection final : public mp::Helpers<Connection> {
+  public:
+    std::string const &get_host() const { return host; }
+
+  private:
+    friend class mp::Helpers<Connection>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string host, int refusals, std::chrono::milliseconds latency
+      ) {
+        ++handshakes;
+        auto wait = (std::min)(
+          std::chrono::duration_cast<mp::DeadlineClock::duration>(latency)
+        , mp::remaining_time()
+        );
+        std::this_thread::sleep_for(wait);
+        if (handshakes <= refusals) return on_fail(RefusedError{});
+        return on_success(mp::builder(constructor, std::move(host)));
+      };
+    }
+
+    std::string host;
+
+  public:
+    Connection(typename mp::Helpers<Connection>::Private, std::string host_)
+      : host{std::move(host_)}
+    {}
+  };
+
+  class Disk final : public mp::Helpers<Disk> {
+  private:
+    friend class mp::Helpers<Disk>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , bool present
+      ) {
+        ++disks_mounted;
+        if (!present) return on_fail(NoDiskError{});
+        return on_success(mp::builder(constructor));
+      };
+    }
+
+  public:
+    Disk(typename mp::Helpers<Disk>::Private) {}
+  };
+
+  class Service final : public mp::Helpers<Service> {
+  public:
+    Connection const &get_connection() const { return connection; }
+
+  private:
+    friend class mp::Helpers<Service>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto connection, auto disk
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::deadline_builders(std::move(connection), std::move(disk))
+        );
+      };
+    }
+
+    Connection connection;
+    Disk disk;
+
+  public:
+    template <typename C, typename D>
+    Service(typename mp::Helpers<Service>::Private, C connection_, D disk_)
+      : connection{std::move(connection_).construct()}
+      , disk{std::move(disk_).construct()}
+    {}
+  };
+
+  enum class Outcome { constructed, refused, no_disk, timed_out };
+
+  template <typename Builder>
+  Outcome outcome_of(Builder builder) {
+    return std::move(builder).construct(
+      [](auto post) {
+        std::move(post).construct();
+        return Outcome::constructed;
+      }
+    , mp::handler(
+        [](RefusedError) { return Outcome::refused; }
+      , [](NoDiskError) { return Outcome::no_disk; }
+      , [](mp::TimeoutError) { return Outcome::timed_out; }
+      )
+    );
+  }
+
+  constexpr std::chrono::milliseconds fast{1};
+  constexpr std::chrono::milliseconds slow{200};
+}
+
+SCENARIO("deadlines") {
+  handshakes = 0;
+  disks_mounted = 0;
+
+  WHEN("construction fits in its budget") {
+    auto outcome = outcome_of(
+      mp::with_deadline(
+        std::chrono::seconds{10}
+      , Service::builder(
+          Connection::builder("db", 0, fast), Disk::builder(true)
+        )
+      )
+    );
+
+    THEN("it succeeds") {
+      REQUIRE(outcome == Outcome::constructed);
+      REQUIRE(disks_mounted == 1);
+    }
+  }
+
+  WHEN("a nested factory uses up the budget") {
+    auto start = mp::DeadlineClock::now();
+    auto outcome = outcome_of(
+      mp::with_deadline(
+        std::chrono::milliseconds{20}
+      , Service::builder(
+          Connection::builder("db", 0, slow), Disk::builder(true)
+        )
+      )
+    );
+    auto elapsed = mp::DeadlineClock::now() - start;
+
+    THEN("later builders aren't invoked and it times out") {
+      REQUIRE(outcome == Outcome::timed_out);
+      REQUIRE(handshakes == 1);
+      REQUIRE(disks_mounted == 0);
+      // The factory bounded its wait by the remaining time
+      REQUIRE(elapsed < slow);
+    }
+  }
+
+  WHEN("the budget is already spent") {
+    auto outcome = outcome_of(
+      mp::with_deadline(
+        std::chrono::milliseconds{0}
+      , Connection::builder("db", 0, fast)
+      )
+    );
+
+    THEN("the builder isn't invoked") {
+      REQUIRE(outcome == Outcome::timed_out);
+      REQUIRE(handshakes == 0);
+    }
+  }
+
+  WHEN("deadlines are nested") {
+    mp::DeadlineClock::duration inner{};
+    auto check = [&](auto&& on_success, auto&&) {
+      inner = mp::remaining_time();
+      return on_success(0);
+    };
+    auto outer_deadline = mp::DeadlineClock::now() + std::chrono::seconds{1};
+    mp::with_deadline(
+      outer_deadline
+    , mp::with_deadline(std::chrono::hours{1}, mp::builder(check))
+    ).construct([](int) {}, [](auto) {});
+
+    THEN("the inner budget can't extend the outer one") {
+      REQUIRE(inner <= std::chrono::seconds{1});
+      REQUIRE(inner > std::chrono::seconds{0});
+      REQUIRE(mp::remaining_time() == mp::DeadlineClock::duration::max());
+      REQUIRE(!mp::deadline_expired());
+    }
+  }
+
+  WHEN("a failing factory is retried") {
+    auto outcome = outcome_of(
+      mp::retry(
+        mp::Backoff{fast, fast, 2, 5}
+      , [] { return Connection::builder("db", 2, fast).own(); }
+      )
+    );
+
+    THEN("it succeeds once the factory does") {
+      REQUIRE(outcome == Outcome::constructed);
+      REQUIRE(handshakes == 3);
+    }
+  }
+
+  WHEN("every attempt fails") {
+    auto outcome = outcome_of(
+      mp::retry(
+        mp::Backoff{fast, fast, 2, 3}
+      , [] { return Connection::builder("db", 100, fast).own(); }
+      )
+    );
+
+    THEN("the last error is reported after the last attempt") {
+      REQUIRE(outcome == Outcome::refused);
+      REQUIRE(handshakes == 3);
+    }
+  }
+
+  WHEN("retries would outlast the deadline") {
+    auto outcome = outcome_of(
+      mp::with_deadline(
+        std::chrono::milliseconds{50}
+      , mp::retry(
+          mp::Backoff{std::chrono::milliseconds{20}, slow, 2, 0}
+        , [] { return Connection::builder("db", 100, fast).own(); }
+        )
+      )
+    );
+
+    THEN("retrying stops with a timeout") {
+      REQUIRE(outcome == Outcome::timed_out);
+      REQUIRE(handshakes >= 1);
+      REQUIRE(handshakes <= 3);
+    }
+  }
+}
@@ -0,0 +1,427 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/allocator.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/heap.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#if __cplusplus >= 201703L
+  #include <memory_resource>
+  #include <string_view>
+#endif
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct Counts {
+    int allocations = 0;
+    int deallocations = 0;
+  };
+
+  // Counts what is allocated from it
+  template <typename T>
+  class CountingAllocator {
+  public:
+    using value_type = T;
+
+    explicit CountingAllocator(Counts &counts_) : counts{&counts_} {}
+
+    template <typename U>
+    CountingAllocator(CountingAllocator<U> const &other)
+      : counts{other.counts}
+    {}
+
+    T *allocate(std::size_t n) {
+      ++counts->allocations;
+      return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T *pointer, std::size_t n) {
+      ++counts->deallocations;
+      std::allocator<T>{}.deallocate(pointer, n);
+    }
+
+    template <typename U>
+    bool operator==(CountingAllocator<U> const &other) const {
+      return counts == other.counts;
+    }
+
+    template <typename U>
+    bool operator!=(CountingAllocator<U> const &other) const {
+      return counts != other.counts;
+    }
+
+  private:
+    template <typename U>
+    friend class CountingAllocator;
+
+    Counts *counts;
+  };
+
+  struct NegativeError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  int destructions = 0;
+
+  class Counter final
+    : public mp::Helpers<Counter>
+    , public mp::PointerHelper<mp::Helpers<Counter>>
+  {
+  public:
+    int get_count() const { return count; }
+
+    ~Counter() { ++destructions; }
+
+  private:
+    friend class mp::Helpers<Counter>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int count
+      ) {
+        if (count < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, count));
+      };
+    }
+
+    int count;
+
+  public:
+    Counter(typename mp::Helpers<Counter>::Private, int count_)
+      : count{count_}
+    {}
+  };
+
+  class Pair final
+    : public mp::Helpers<Pair>
+    , public mp::PointerHelper<mp::Helpers<Pair>>
+  {
+  public:
+    Counter const &get_first() const { return first; }
+    std::string const &get_label() const { return label; }
+
+  private:
+    friend class mp::Helpers<Pair>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto first, auto label
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(first), std::move(label))
+        , mp::arguments()
+        );
+      };
+    }
+
+    Counter first;
+    std::string label;
+
+  public:
+    template <typename C, typename L>
+    Pair(typename mp::Helpers<Pair>::Private, C first_, L label_)
+      : first{std::move(first_).construct()}
+      , label{std::move(label_).construct()}
+    {}
+  };
+
+  class Node final
+    : public mp::Helpers<Node>
+    , public mp::PointerHelper<mp::Helpers<Node>>
+    , public std::enable_shared_from_this<Node>
+  {
+  public:
+    int get_id() const { return id; }
+
+  private:
+    friend class mp::Helpers<Node>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int id
+      ) {
+        if (id < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, id));
+      };
+    }
+
+    int id;
+
+  public:
+    Node(typename mp::Helpers<Node>::Private, int id_) : id{id_} {}
+  };
+
+  auto pair_builder(int count) {
+    return Pair::builder(
+      Counter::builder(count), mp::wrapper<std::string>("label")
+    ).own();
+  }
+}
+
+SCENARIO("heap construction") {
+  destructions = 0;
+  Counts counts;
+  CountingAllocator<char> allocator{counts};
+  std::string error;
+  auto on_fail = [&](auto e) { error = e.description; };
+
+  WHEN("a unique instance is constructed") {
+    auto pair = Pair::unique(
+      Counter::builder(3), mp::wrapper<std::string>("label")
+    ).construct(on_fail);
+
+    THEN("it owns the object") {
+      REQUIRE(pair != nullptr);
+      REQUIRE(pair->get_first().get_count() == 3);
+      REQUIRE(pair->get_label() == "label");
+    }
+  }
+
+  WHEN("a shared instance is constructed") {
+    std::shared_ptr<Counter> counter = Counter::shared(4).construct(on_fail);
+
+    THEN("it owns the object") {
+      REQUIRE(counter->get_count() == 4);
+      counter.reset();
+      REQUIRE(destructions == 1);
+    }
+  }
+
+  WHEN("a unique instance is constructed with an allocator") {
+    auto counter = Counter::allocate_unique(allocator, 5).construct(on_fail);
+
+    THEN("the allocator provides its storage") {
+      REQUIRE(counter->get_count() == 5);
+      REQUIRE(counts.allocations == 1);
+      counter.reset();
+      REQUIRE(destructions == 1);
+      REQUIRE(counts.deallocations == 1);
+    }
+  }
+
+  WHEN("a shared instance is constructed with an allocator") {
+    auto pair = Pair::allocate_shared(
+      allocator, Counter::builder(6), mp::wrapper<std::string>("label")
+    ).construct(on_fail);
+
+    THEN("the object and the control block share one allocation") {
+      REQUIRE(pair->get_first().get_count() == 6);
+      REQUIRE(counts.allocations == 1);
+      pair.reset();
+      REQUIRE(counts.deallocations == 1);
+    }
+  }
+
+  WHEN("a factory fails") {
+    auto unique = Counter::allocate_unique(allocator, -1).construct(on_fail);
+    auto shared = Pair::allocate_shared(
+      allocator, Counter::builder(-1), mp::wrapper<std::string>("label")
+    ).construct(on_fail);
+
+    THEN("the pointers are empty and nothing is allocated") {
+      REQUIRE(unique == nullptr);
+      REQUIRE(shared == nullptr);
+      REQUIRE(error == "Value is negative");
+      REQUIRE(counts.allocations == 0);
+    }
+  }
+
+  WHEN("a type that shares itself is constructed") {
+    auto shared = Node::shared(1).construct(on_fail);
+    auto allocated = Node::allocate_shared(allocator, 2).construct(on_fail);
+    auto made = Node::builder(3).construct(
+      [](auto builder) { return mp::make_shared(std::move(builder)); }
+    , [](auto) { return std::shared_ptr<Node>{}; }
+    );
+
+    THEN("the control block owns it and shared_from_this works") {
+      REQUIRE(shared->shared_from_this() == shared);
+      REQUIRE(allocated->shared_from_this() == allocated);
+      REQUIRE(made->shared_from_this() == made);
+      REQUIRE(made->get_id() == 3);
+      REQUIRE(counts.allocations == 1);
+    }
+  }
+
+  WHEN("a post-factory builder is constructed on the heap") {
+    auto result = pair_builder(7).construct(
+      [&](auto builder) {
+        auto pair = mp::allocate_unique(allocator, std::move(builder));
+        return pair->get_first().get_count();
+      }
+    , [](auto) { return -1; }
+    );
+
+    THEN("the free functions work the same way") {
+      REQUIRE(result == 7);
+      REQUIRE(counts.allocations == 1);
+      REQUIRE(counts.deallocations == 1);
+    }
+  }
+}
+
+#if __cplusplus >= 201703L
+namespace {
+  // Neither copyable nor movable
+  class Mutex final : public mp::Helpers<Mutex> {
+  public:
+    Mutex(Mutex const &) = delete;
+    Mutex &operator=(Mutex const &) = delete;
+
+    int get_id() const { return id; }
+
+  private:
+    friend class mp::Helpers<Mutex>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int id
+      ) {
+        if (id < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, id));
+      };
+    }
+
+    int id;
+
+  public:
+    Mutex(typename mp::Helpers<Mutex>::Private, int id_) : id{id_} {}
+  };
+
+  class Guarded final
+    : public mp::Helpers<Guarded>
+    , public mp::PointerHelper<mp::Helpers<Guarded>>
+  {
+  public:
+    Guarded(Guarded const &) = delete;
+    Guarded &operator=(Guarded const &) = delete;
+
+    Mutex const &get_mutex() const { return mutex; }
+
+  private:
+    friend class mp::Helpers<Guarded>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto mutex
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(mutex))
+        , mp::arguments()
+        );
+      };
+    }
+
+    Mutex mutex;
+
+  public:
+    template <typename M>
+    Guarded(typename mp::Helpers<Guarded>::Private, M mutex_)
+      : mutex{std::move(mutex_).construct()}
+    {}
+  };
+
+  class Name final
+    : public mp::Helpers<Name>
+    , public mp::AllocatorHelper<mp::Helpers<Name>>
+    , public mp::PointerHelper<mp::Helpers<Name>>
+  {
+  public:
+    using allocator_type = mp::Allocator;
+
+    std::pmr::string const &get_name() const { return name; }
+
+  private:
+    friend class mp::Helpers<Name>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&&
+      , std::string_view name
+      ) {
+        return on_success(mp::builder(constructor, name));
+      };
+    }
+
+    std::pmr::string name;
+
+  public:
+    Name(
+      typename mp::Helpers<Name>::Private
+    , std::allocator_arg_t, allocator_type const &allocator
+    , std::string_view name_
+    ) : name{name_, allocator}
+    {}
+  };
+}
+
+SCENARIO("heap construction of types that can't move") {
+  Counts counts;
+  CountingAllocator<char> allocator{counts};
+  auto on_fail = [](auto) {};
+
+  WHEN("they are constructed on the heap") {
+    auto unique = Guarded::unique(Mutex::builder(1)).construct(on_fail);
+    auto shared = Guarded::shared(Mutex::builder(2)).construct(on_fail);
+    auto allocated_unique = Guarded::allocate_unique(
+      allocator, Mutex::builder(3)
+    ).construct(on_fail);
+    auto allocated_shared = Guarded::allocate_shared(
+      allocator, Mutex::builder(4)
+    ).construct(on_fail);
+
+    THEN("the object is constructed in place") {
+      REQUIRE(unique->get_mutex().get_id() == 1);
+      REQUIRE(shared->get_mutex().get_id() == 2);
+      REQUIRE(allocated_unique->get_mutex().get_id() == 3);
+      REQUIRE(allocated_shared->get_mutex().get_id() == 4);
+      REQUIRE(counts.allocations == 2);
+    }
+  }
+
+  WHEN("an allocator-aware type is allocated with a polymorphic allocator") {
+    std::pmr::unsynchronized_pool_resource pool;
+    std::pmr::string const long_name = "a name that is long enough to allocate";
+    std::shared_ptr<Name> name;
+    {
+      mp::ResourceScope scope{pool};
+      name = Name::allocate_shared(
+        std::pmr::polymorphic_allocator<Name>{&pool}, long_name
+      ).construct(on_fail);
+    }
+
+    THEN("the allocator only provides its storage") {
+      REQUIRE(name->get_name() == long_name);
+      REQUIRE(name->get_name().get_allocator().resource() == &pool);
+    }
+  }
+}
+#endif
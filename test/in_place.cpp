@@ -0,0 +1,207 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/in_place.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <string>
+#include <type_traits>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  int copies = 0;
+  int moves = 0;
+
+  struct Counted {
+    explicit Counted(int value_) : value{value_} {}
+    Counted(Counted const &other) : value{other.value} { ++copies; }
+    Counted(Counted &&other) : value{other.value} { ++moves; }
+
+    int value;
+  };
+
+  struct EmptyError {
+    static constexpr auto description = "Name is empty";
+  };
+
+  class Leaf final : public mp::Helpers<Leaf> {
+  public:
+    std::string const &get_name() const { return name; }
+    int get_value() const { return counted.value; }
+
+  private:
+    friend class mp::Helpers<Leaf>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name, int value
+      ) {
+        if (name.empty()) return on_fail(EmptyError{});
+        return on_success(mp::builder(constructor, std::move(name), value));
+      };
+    }
+
+    std::string name;
+    Counted counted;
+
+  public:
+    Leaf(typename mp::Helpers<Leaf>::Private, std::string name_, int value_)
+      : name{std::move(name_)}, counted{value_}
+    {}
+  };
+
+  class Tree final : public mp::Helpers<Tree> {
+  public:
+    Leaf const &get_left() const { return left; }
+    Leaf const &get_right() const { return right; }
+
+  private:
+    friend class mp::Helpers<Tree>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto left, auto right
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(left), std::move(right))
+        );
+      };
+    }
+
+    Leaf left;
+    Leaf right;
+
+  public:
+    template <typename L, typename R>
+    Tree(typename mp::Helpers<Tree>::Private, L left_, R right_)
+      : left{std::move(left_).construct()}
+      , right{std::move(right_).construct()}
+    {}
+
+#if __cplusplus >= 201703L
+    // Neither the tree nor its leaves ever need to move
+    Tree(Tree const &) = delete;
+    Tree(Tree &&) = delete;
+#endif
+  };
+
+  auto make_tree(std::string left, std::string right) {
+    return Tree::builder(
+      Leaf::builder(std::move(left), 1)
+    , Leaf::builder(std::move(right), 2)
+    ).own();
+  }
+}
+
+SCENARIO("in-place construction") {
+  copies = 0;
+  moves = 0;
+
+  WHEN("a builder graph is constructed in raw storage") {
+    std::aligned_storage_t<sizeof(Tree), alignof(Tree)> storage;
+    Tree *tree = make_tree("left", "right").construct(
+      [&](auto builder) {
+        return mp::construct_at(&storage, std::move(builder));
+      }
+    , [](auto) -> Tree * { return nullptr; }
+    );
+
+    THEN("the object lives in the storage") {
+      REQUIRE(static_cast<void *>(tree) == static_cast<void *>(&storage));
+      REQUIRE(tree->get_left().get_name() == "left");
+      REQUIRE(tree->get_right().get_value() == 2);
+      tree->~Tree();
+    }
+
+#if __cplusplus >= 201703L
+    THEN("nothing was moved or copied") {
+      tree->~Tree();
+      REQUIRE(moves == 0);
+      REQUIRE(copies == 0);
+    }
+#endif
+  }
+
+  WHEN("a factory fails") {
+    std::aligned_storage_t<sizeof(Tree), alignof(Tree)> storage;
+    Tree *tree = make_tree("left", "").construct(
+      [&](auto builder) {
+        return mp::construct_at(&storage, std::move(builder));
+      }
+    , [](auto) -> Tree * { return nullptr; }
+    );
+
+    THEN("the storage is left alone") {
+      REQUIRE(tree == nullptr);
+    }
+  }
+
+#if __cplusplus >= 201703L
+  WHEN("a builder graph is emplaced into an optional") {
+    std::optional<Tree> tree;
+    make_tree("left", "right").construct(
+      [&](auto builder) { mp::emplace(tree, std::move(builder)); }
+    , [](auto) {}
+    );
+
+    THEN("it is constructed without moves") {
+      REQUIRE(tree.has_value());
+      REQUIRE(tree->get_right().get_name() == "right");
+      REQUIRE(moves == 0);
+      REQUIRE(copies == 0);
+    }
+  }
+
+  WHEN("a builder graph is emplaced into a variant") {
+    std::variant<std::monostate, Tree, EmptyError> result;
+    make_tree("left", "right").construct(
+      [&](auto builder) { mp::emplace(result, std::move(builder)); }
+    , [&](auto error) { result.template emplace<EmptyError>(error); }
+    );
+
+    THEN("it is constructed without moves") {
+      REQUIRE(std::holds_alternative<Tree>(result));
+      REQUIRE(std::get<Tree>(result).get_left().get_value() == 1);
+      REQUIRE(moves == 0);
+      REQUIRE(copies == 0);
+    }
+  }
+
+  WHEN("emplacing fails") {
+    std::variant<std::monostate, Tree, EmptyError> result;
+    make_tree("", "right").construct(
+      [&](auto builder) { mp::emplace(result, std::move(builder)); }
+    , [&](auto error) { result.template emplace<EmptyError>(error); }
+    );
+
+    THEN("the failure callback fills the variant instead") {
+      REQUIRE(std::holds_alternative<EmptyError>(result));
+    }
+  }
+
+  WHEN("the optional and variant helpers are used") {
+    auto optional = Leaf::optional("leaf", 3).construct([](auto) {});
+    auto variant = Leaf::variant<EmptyError>("leaf", 4);
+
+    THEN("they don't move either") {
+      REQUIRE(optional->get_value() == 3);
+      REQUIRE(std::get<Leaf>(variant).get_value() == 4);
+      REQUIRE(moves == 0);
+      REQUIRE(copies == 0);
+    }
+  }
+#endif
+}
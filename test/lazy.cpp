@@ -0,0 +1,169 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/lazy.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  std::atomic<int> tables_constructed{0};
+
+  struct NoRoutesError {
+    static constexpr auto description = "Routing table needs a route";
+  };
+
+  struct PortRangeError {
+    static constexpr auto description = "Port is out of range";
+  };
+
+  // Expensive to construct, and only needed by some requests
+  class Table final : public mp::Helpers<Table> {
+  public:
+    std::size_t size() const { return routes.size(); }
+    std::string const &route(std::size_t i) const { return routes[i]; }
+
+  private:
+    friend class mp::Helpers<Table>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string prefix, int count
+      ) {
+        if (count <= 0) return on_fail(NoRoutesError{});
+        return on_success(mp::builder(constructor, std::move(prefix), count));
+      };
+    }
+
+    std::vector<std::string> routes;
+
+  public:
+    Table(typename mp::Helpers<Table>::Private, std::string prefix, int count)
+    {
+      // Slow enough that concurrent first uses overlap
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      for (int i = 0; i < count; ++i) {
+        routes.push_back(prefix + std::to_string(i));
+      }
+      ++tables_constructed;
+    }
+  };
+
+  class Router final : public mp::Helpers<Router> {
+  public:
+    int get_port() const { return port; }
+    mp::Lazy<Table> const &get_table() const { return table; }
+
+  private:
+    friend class mp::Helpers<Router>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int port, auto table
+      ) {
+        if (port <= 0 || port > 65535) return on_fail(PortRangeError{});
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(table))
+        , mp::arguments(port)
+        );
+      };
+    }
+
+    int port;
+    mp::Lazy<Table> table;
+
+  public:
+    template <typename T>
+    Router(typename mp::Helpers<Router>::Private, int port_, T table_)
+      : port{port_}
+      , table{mp::lazy(std::move(table_))}
+    {}
+  };
+
+  template <typename Builder>
+  std::vector<Router> build(Builder builder) {
+    std::vector<Router> routers;
+    std::move(builder).construct(
+      [&](auto post) { routers.push_back(std::move(post).construct()); }
+    , [](auto) {}
+    );
+    return routers;
+  }
+}
+
+SCENARIO("lazy members") {
+  tables_constructed = 0;
+
+  WHEN("an aggregate with a lazy member is constructed") {
+    // The prefix is a temporary, so the lazy member has to own it
+    auto routers = build(
+      Router::builder(80, Table::builder(std::string{"/api/v"}, 3))
+    );
+
+    THEN("the member isn't constructed until it is used") {
+      REQUIRE(routers.size() == 1);
+      auto const &table = routers[0].get_table();
+      REQUIRE(!table.is_constructed());
+      REQUIRE(tables_constructed == 0);
+      REQUIRE(table->size() == 3);
+      REQUIRE(table->route(2) == "/api/v2");
+      REQUIRE(table.is_constructed());
+      REQUIRE(table.get().size() == 3);
+      REQUIRE(tables_constructed == 1);
+    }
+  }
+
+  WHEN("the lazy member's factory fails") {
+    auto routers = build(Router::builder(80, Table::builder("/", 0)));
+
+    THEN("the aggregate isn't constructed") {
+      REQUIRE(routers.empty());
+      REQUIRE(tables_constructed == 0);
+    }
+  }
+
+  WHEN("the aggregate is moved") {
+    auto routers = build(Router::builder(443, Table::builder("/", 2)));
+    Router moved = std::move(routers[0]);
+
+    THEN("the lazy member moves with it") {
+      REQUIRE(moved.get_port() == 443);
+      REQUIRE(moved.get_table()->route(1) == "/1");
+    }
+  }
+
+  WHEN("several threads use the member at once") {
+    auto routers = build(Router::builder(8080, Table::builder("/", 100)));
+    auto const &table = routers[0].get_table();
+    std::atomic<std::size_t> total{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+      threads.emplace_back([&] { total += table->size(); });
+    }
+    for (auto &thread : threads) thread.join();
+
+    THEN("it is constructed once") {
+      REQUIRE(tables_constructed == 1);
+      REQUIRE(total == 800);
+    }
+  }
+}
@@ -0,0 +1,237 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/construct_helpers.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/forward_tuple.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/in_place.hpp>
+#include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/tuple_list.hpp>
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct NegativeError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  // Nothing in this class can throw
+  class Cell final : public mp::Helpers<Cell> {
+  public:
+    int get_value() const noexcept { return value; }
+
+  private:
+    friend class mp::Helpers<Cell>;
+
+    static auto factory() noexcept {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int value
+      ) noexcept(noexcept(on_success(mp::builder(constructor, value)))) {
+        if (value < 0) return on_fail(NegativeError{});
+        return on_success(mp::builder(constructor, value));
+      };
+    }
+
+    int value;
+
+  public:
+    Cell(typename mp::Helpers<Cell>::Private, int value_) noexcept
+      : value{value_}
+    {}
+  };
+
+  // Nothing in this class can throw, provided its members can't
+  class Row final : public mp::Helpers<Row> {
+  public:
+    int sum() const noexcept { return left.get_value() + right.get_value(); }
+
+  private:
+    friend class mp::Helpers<Row>;
+
+    static auto factory() noexcept {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto left, auto right
+      ) noexcept(noexcept(
+        mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(left), std::move(right))
+        )
+      )) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(left), std::move(right))
+        );
+      };
+    }
+
+    Cell left;
+    Cell right;
+
+  public:
+    template <typename L, typename R>
+    Row(typename mp::Helpers<Row>::Private, L left_, R right_) noexcept(
+      noexcept(std::move(left_).construct())
+      && noexcept(std::move(right_).construct())
+    ) : left{std::move(left_).construct()}
+      , right{std::move(right_).construct()}
+    {}
+  };
+
+  // Its constructor allocates
+  class Label final : public mp::Helpers<Label> {
+  public:
+    std::string const &get_text() const noexcept { return text; }
+
+  private:
+    friend class mp::Helpers<Label>;
+
+    static auto factory() noexcept {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&&
+      , char const *text
+      ) noexcept(noexcept(on_success(mp::builder(constructor, text)))) {
+        return on_success(mp::builder(constructor, text));
+      };
+    }
+
+    std::string text;
+
+  public:
+    Label(typename mp::Helpers<Label>::Private, char const *text_)
+      : text{text_}
+    {}
+  };
+
+  struct OnSuccess {
+    template <typename Builder>
+    int operator()(Builder builder) const noexcept(noexcept(
+      std::move(builder).construct()
+    )) {
+      return std::move(builder).construct().sum();
+    }
+  };
+
+  struct Discard {
+    template <typename Builder>
+    int operator()(Builder builder) const noexcept(noexcept(
+      std::move(builder).construct()
+    )) {
+      std::move(builder).construct();
+      return 0;
+    }
+  };
+
+  struct OnFail {
+    template <typename Error>
+    int operator()(Error) const noexcept { return -1; }
+  };
+
+  struct Plain {
+    int value;
+  };
+
+  struct Throwing {
+    Throwing(int) {}
+  };
+
+  struct Sticky {
+    Sticky() = default;
+    Sticky(Sticky &&) noexcept(false) {}
+  };
+
+  template <typename Builder, typename OnSuccess = Discard>
+  constexpr bool nothrow = noexcept(
+    std::declval<Builder>().construct(OnSuccess{}, OnFail{})
+  );
+
+  template <typename Builder>
+  constexpr bool nothrow_post = noexcept(std::declval<Builder>().construct());
+
+  auto add = [](int a, int b) noexcept { return a + b; };
+  auto add_throwing = [](int a, int b) { return a + b; };
+}
+
+SCENARIO("noexcept propagation") {
+  WHEN("every factory, constructor and callback is noexcept") {
+    auto row = Row::builder(Cell::builder(1), Cell::builder(2));
+
+    THEN("constructing the whole graph is noexcept") {
+      static_assert(nothrow<decltype(row), OnSuccess>, "");
+      static_assert(
+        noexcept(Row::builder(Cell::builder(1), Cell::builder(2))), ""
+      );
+      REQUIRE(std::move(row).construct(OnSuccess{}, OnFail{}) == 3);
+      REQUIRE(
+        Row::builder(Cell::builder(-1), Cell::builder(2))
+          .construct(OnSuccess{}, OnFail{}) == -1
+      );
+    }
+
+    THEN("builders and instances move without throwing") {
+      static_assert(
+        std::is_nothrow_move_constructible<decltype(row)>::value, ""
+      );
+      static_assert(std::is_nothrow_move_constructible<Row>::value, "");
+    }
+  }
+
+  WHEN("a nested constructor can throw") {
+    auto label = Label::builder("text");
+
+    THEN("so can constructing the graph") {
+      static_assert(!nothrow<decltype(label)>, "");
+      REQUIRE(std::move(label).construct(Discard{}, OnFail{}) == 0);
+    }
+  }
+
+  WHEN("the building blocks are used directly") {
+    THEN("they are noexcept exactly when what they call is") {
+      auto pair = std::make_tuple(1, 2);
+      static_assert(noexcept(mp::forward_tuple(add, pair)), "");
+      static_assert(!noexcept(mp::forward_tuple(add_throwing, pair)), "");
+      static_assert(nothrow_post<decltype(mp::builder(add, 1, 2))>, "");
+      static_assert(
+        !nothrow_post<decltype(mp::builder(add_throwing, 1, 2))>, ""
+      );
+      static_assert(
+        nothrow_post<decltype(mp::builder(mp::braced_construct<Plain>, 1))>, ""
+      );
+      static_assert(
+        !nothrow_post<decltype(mp::builder(mp::construct<Throwing>, 1))>, ""
+      );
+      static_assert(nothrow<decltype(mp::wrapper<Plain>(1))>, "");
+      static_assert(!nothrow<decltype(mp::wrapper<Throwing>(1))>, "");
+      auto numbers = std::make_tuple(1, 2.0);
+      auto mixed = std::make_tuple(Sticky{}, 1);
+      static_assert(noexcept(mp::tuple_list::split(std::move(numbers))), "");
+      static_assert(!noexcept(mp::tuple_list::split(std::move(mixed))), "");
+      static_assert(
+        noexcept(mp::tuple_list::combine(std::move(numbers), 3)), ""
+      );
+      static_assert(
+        !noexcept(mp::tuple_list::combine(std::move(numbers), Sticky{})), ""
+      );
+      auto builder = mp::builder(add, 1, 2);
+      static_assert(noexcept(int(mp::in_place(std::move(builder)))), "");
+      REQUIRE(int(mp::in_place(std::move(builder))) == 3);
+    }
+  }
+}
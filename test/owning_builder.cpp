@@ -0,0 +1,302 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/builder.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct EmptyNameError {
+    static constexpr auto description = "Name is empty";
+  };
+
+  // Counts how it was stored
+  struct Payload {
+    static int copies;
+    static int moves;
+
+    std::string text;
+
+    explicit Payload(std::string text_) : text{std::move(text_)} {}
+    Payload(Payload const &other) : text{other.text} { ++copies; }
+    Payload(Payload &&other) noexcept : text{std::move(other.text)} {
+      ++moves;
+    }
+  };
+
+  int Payload::copies = 0;
+  int Payload::moves = 0;
+
+  class Channel final : public mp::Helpers<Channel> {
+  public:
+    std::string const &get_name() const { return name; }
+    std::string const &get_payload() const { return payload; }
+
+  private:
+    friend class mp::Helpers<Channel>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name, Payload const &payload
+      ) {
+        if (name.empty()) return on_fail(EmptyNameError{});
+        return on_success(
+          mp::builder(constructor, std::move(name), payload.text)
+        );
+      };
+    }
+
+    std::string name;
+    std::string payload;
+
+  public:
+    Channel(
+      typename mp::Helpers<Channel>::Private
+    , std::string name_, std::string payload_
+    ) : name{std::move(name_)}
+      , payload{std::move(payload_)}
+    {}
+  };
+
+  class Mixer final : public mp::Helpers<Mixer> {
+  public:
+    Channel const &get_left() const { return left; }
+    Channel const &get_right() const { return right; }
+    int get_gain() const { return *gain; }
+
+  private:
+    friend class mp::Helpers<Mixer>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto left, auto right, std::unique_ptr<int> gain
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(left), std::move(right))
+        , mp::arguments(std::move(gain))
+        );
+      };
+    }
+
+    std::unique_ptr<int> gain;
+    Channel left;
+    Channel right;
+
+  public:
+    template <typename L, typename R>
+    Mixer(
+      typename mp::Helpers<Mixer>::Private
+    , std::unique_ptr<int> gain_, L left_, R right_
+    ) : gain{std::move(gain_)}
+      , left{std::move(left_).construct()}
+      , right{std::move(right_).construct()}
+    {}
+  };
+
+  // A minimal background worker
+  class Worker {
+  public:
+    Worker() : thread{[this] { run(); }} {}
+
+    ~Worker() {
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        done = true;
+      }
+      ready.notify_one();
+      thread.join();
+    }
+
+    void post(std::function<void()> job) {
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        jobs.push_back(std::move(job));
+      }
+      ready.notify_one();
+    }
+
+  private:
+    void run() {
+      std::unique_lock<std::mutex> lock{mutex};
+      while (true) {
+        ready.wait(lock, [this] { return done || !jobs.empty(); });
+        if (jobs.empty()) return;
+        auto job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+      }
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> jobs;
+    bool done = false;
+    std::thread thread;
+  };
+
+  // Builds the channel on the worker and hands back its name, or the error
+  template <typename Builder>
+  std::string build_on(Worker &worker, Builder builder) {
+    std::string result;
+    std::thread::id builder_thread;
+    {
+      std::mutex mutex;
+      std::condition_variable finished;
+      bool is_finished = false;
+      worker.post([&, builder]() mutable {
+        auto name = std::move(builder).construct(
+          [](auto post) { return std::move(post).construct().get_name(); }
+        , [](auto error) { return std::string{error.description}; }
+        );
+        std::lock_guard<std::mutex> lock{mutex};
+        result = std::move(name);
+        builder_thread = std::this_thread::get_id();
+        is_finished = true;
+        finished.notify_one();
+      });
+      std::unique_lock<std::mutex> lock{mutex};
+      finished.wait(lock, [&] { return is_finished; });
+    }
+    REQUIRE(builder_thread != std::this_thread::get_id());
+    return result;
+  }
+
+  auto make_channel(std::string name) {
+    // Everything the builder refers to is gone when this returns
+    return Channel::owning_builder(std::move(name), Payload{"data"});
+  }
+}
+
+SCENARIO("owning builders") {
+  Payload::copies = 0;
+  Payload::moves = 0;
+
+  WHEN("an owning builder outlives the scope of its arguments") {
+    auto builder = make_channel("left");
+    Worker worker;
+    auto name = build_on(worker, std::move(builder));
+
+    THEN("it can be constructed later on another thread") {
+      REQUIRE(name == "left");
+    }
+  }
+
+  WHEN("the factory fails on the other thread") {
+    Worker worker;
+    auto name = build_on(worker, make_channel(""));
+
+    THEN("the failure is reported there") {
+      REQUIRE(name == "Name is empty");
+    }
+  }
+
+  WHEN("arguments are stored") {
+    Payload lvalue{"copied"};
+    auto copied = Channel::owning_builder("a", lvalue);
+    auto moved = Channel::owning_builder("b", Payload{"moved"});
+
+    THEN("lvalues are copied and rvalues are moved") {
+      REQUIRE(Payload::copies == 1);
+      REQUIRE(Payload::moves > 0);
+      std::move(copied).construct(
+        [](auto post) {
+          REQUIRE(std::move(post).construct().get_payload() == "copied");
+        }
+      , [](auto) { REQUIRE(false); }
+      );
+    }
+  }
+
+  WHEN("builders are nested") {
+    auto builder = [] {
+      std::string right{"right"};
+      return Mixer::owning_builder(
+        Channel::builder(std::string{"left"}, Payload{"l"})
+      , Channel::builder(right, Payload{"r"})
+      , std::make_unique<int>(3)
+      );
+    }();
+
+    std::string summary;
+    std::thread thread{[&] {
+      summary = std::move(builder).construct(
+        [](auto post) {
+          auto mixer = std::move(post).construct();
+          return mixer.get_left().get_name() + " "
+            + mixer.get_right().get_name() + " "
+            + mixer.get_right().get_payload() + " "
+            + std::to_string(mixer.get_gain());
+        }
+      , [](auto) { return std::string{}; }
+      );
+    }};
+    thread.join();
+
+    THEN("the nested builders own their arguments too") {
+      REQUIRE(summary == "left right r 3");
+    }
+  }
+
+  WHEN("an owned post-factory builder outlives its factory") {
+    std::function<std::string()> later;
+    {
+      std::string label{"pair"};
+      mp::builder(
+        [](
+          auto&& on_success, auto&& on_fail
+        , std::string label_, auto left, auto right
+        ) {
+          // Holds state, and is wrapped because the builders are reordered
+          auto constructor = [label_](auto left_, auto right_) {
+            return label_
+              + " " + std::move(left_).construct().get_name()
+              + " " + std::move(right_).construct().get_name();
+          };
+          return mp::multifail(
+            constructor
+          , on_success, on_fail
+          , mp::builders(mp::cost<10>(std::move(left)), std::move(right))
+          );
+        }
+      , label
+      , Channel::builder(std::string{"left"}, Payload{"l"})
+      , Channel::builder(std::string{"right"}, Payload{"r"})
+      ).construct(
+        [&](auto builder) {
+          using Owned = decltype(std::move(builder).own());
+          auto owned = std::make_shared<Owned>(std::move(builder).own());
+          later = [owned] { return std::move(*owned).construct(); };
+        }
+      , [](auto) {}
+      );
+    }
+
+    THEN("it owns the constructor as well") {
+      REQUIRE(later() == "pair left right");
+    }
+  }
+}
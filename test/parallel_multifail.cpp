@@ -0,0 +1,275 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/parallel_multifail.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  // Factories that wait here only get through if enough of them run at the
+  // same time, which proves that they really run concurrently.
+  class Rendezvous {
+  public:
+    void reset(int expected_) {
+      std::lock_guard<std::mutex> lock{mutex};
+      expected = expected_;
+      arrived = 0;
+    }
+
+    bool arrive() {
+      std::unique_lock<std::mutex> lock{mutex};
+      ++arrived;
+      condition.notify_all();
+      return condition.wait_for(
+        lock, std::chrono::seconds{5}, [this] { return arrived >= expected; }
+      );
+    }
+
+  private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    int expected = 0;
+    int arrived = 0;
+  };
+
+  Rendezvous rendezvous;
+  std::atomic<int> factory_calls{0};
+
+  constexpr int meet = 1000;
+  constexpr int explode = 2000;
+
+  struct NegativeError {
+    static constexpr auto description = "Value is negative";
+  };
+
+  struct TimeoutError {
+    static constexpr auto description = "Other factories never showed up";
+  };
+
+  template <int Index>
+  class Member final : public mp::Helpers<Member<Index>> {
+  public:
+    int get() const { return value; }
+
+  private:
+    friend class mp::Helpers<Member>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int value
+      ) {
+        ++factory_calls;
+        if (value < 0) return on_fail(NegativeError{});
+        if (value == meet && !rendezvous.arrive()) {
+          return on_fail(TimeoutError{});
+        }
+        return on_success(mp::builder(constructor, value));
+      };
+    }
+
+    int value;
+
+  public:
+    Member(typename mp::Helpers<Member>::Private, int value_)
+      : value{value_}
+    {
+      if (value == explode) throw std::runtime_error{"explode"};
+    }
+  };
+
+  template <typename ...Members>
+  class Aggregate final : public mp::Helpers<Aggregate<Members...>> {
+  public:
+    template <std::size_t Index>
+    int get() const { return std::get<Index>(members).get(); }
+
+  private:
+    friend class mp::Helpers<Aggregate>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto& executor
+      , auto... member_builders
+      ) {
+        return mp::parallel_multifail(
+          executor
+        , constructor
+        , on_success, on_fail
+        , mp::builders(std::move(member_builders)...)
+        );
+      };
+    }
+
+    std::tuple<Members...> members;
+
+  public:
+    template <typename ...Builders>
+    Aggregate(
+      typename mp::Helpers<Aggregate>::Private
+    , Builders... member_builders
+    ) : members{std::move(member_builders).construct()...}
+    {}
+  };
+
+  // Never runs anything itself, so the calling thread has to do all the work
+  struct DeferredExecutor {
+    std::vector<std::function<void()>> tasks;
+
+    void operator()(std::function<void()> task) {
+      tasks.push_back(std::move(task));
+    }
+  };
+
+  struct InlineExecutor {
+    template <typename Task>
+    void operator()(Task task) const { task(); }
+  };
+
+  struct C {
+    int int_a;
+    int int_b;
+  };
+}
+
+SCENARIO("parallel multifail") {
+  factory_calls = 0;
+
+  WHEN("every factory has to wait for the others") {
+    rendezvous.reset(3);
+    mp::ThreadExecutor executor;
+    int sum = Aggregate<Member<0>, Member<1>, Member<2>>::builder(
+      executor
+    , Member<0>::builder(meet)
+    , Member<1>::builder(meet)
+    , Member<2>::builder(meet)
+    ).construct(
+      [](auto builder) {
+        auto aggregate = std::move(builder).construct();
+        return aggregate.template get<0>()
+          + aggregate.template get<1>()
+          + aggregate.template get<2>();
+      }
+    , [](auto) { return -1; }
+    );
+
+    THEN("the factories ran concurrently and the aggregate was constructed") {
+      REQUIRE(sum == 3 * meet);
+      REQUIRE(factory_calls == 3);
+    }
+  }
+
+  WHEN("several factories fail") {
+    int failures = 0;
+    bool success = false;
+    mp::ThreadExecutor executor;
+    Aggregate<Member<0>, Member<1>, Member<2>, Member<3>>::builder(
+      executor
+    , Member<0>::builder(-1)
+    , Member<1>::builder(1)
+    , Member<2>::builder(-2)
+    , Member<3>::builder(3)
+    ).construct(
+      [&](auto) { success = true; }
+    , mp::handler(
+        [&](NegativeError) { ++failures; }
+      , [&](TimeoutError) { REQUIRE(false); }
+      )
+    );
+
+    THEN("the failure callback is called exactly once") {
+      REQUIRE(!success);
+      REQUIRE(failures == 1);
+    }
+  }
+
+  WHEN("the executor never runs its tasks") {
+    DeferredExecutor executor;
+    bool failed = false;
+    Aggregate<Member<0>, Member<1>, Member<2>>::builder(
+      executor
+    , Member<0>::builder(-1)
+    , Member<1>::builder(1)
+    , Member<2>::builder(2)
+    ).construct(
+      [&](auto) { REQUIRE(false); }
+    , [&](auto) { failed = true; }
+    );
+
+    THEN("the calling thread cancels the remaining factories") {
+      REQUIRE(failed);
+      REQUIRE(factory_calls == 1);
+    }
+
+    THEN("tasks that run late do nothing") {
+      for (auto &task : executor.tasks) task();
+      REQUIRE(factory_calls == 1);
+    }
+  }
+
+  WHEN("the executor runs tasks inline") {
+    InlineExecutor executor;
+    auto res = Aggregate<Member<0>, Member<1>, C>::builder(
+      executor
+    , Member<0>::builder(4)
+    , Member<1>::builder(5)
+    , mp::wrapper<C>(6, 7)
+    ).construct(
+      [](auto builder) {
+        auto aggregate = std::move(builder).construct();
+        return aggregate.template get<0>() + aggregate.template get<1>();
+      }
+    , [](auto) { return -1; }
+    );
+
+    THEN("the calling thread constructs everything") {
+      REQUIRE(res == 9);
+    }
+  }
+
+  WHEN("a constructor throws while the other factories are parked") {
+    rendezvous.reset(2);
+    bool thrown = false;
+    {
+      mp::ThreadExecutor executor;
+      try {
+        Aggregate<Member<0>, Member<1>, Member<2>>::builder(
+          executor
+        , Member<0>::builder(meet)
+        , Member<1>::builder(meet)
+        , Member<2>::builder(explode)
+        ).construct(
+          [](auto builder) { std::move(builder).construct(); }
+        , [](auto) {}
+        );
+      } catch (std::runtime_error const &) {
+        thrown = true;
+      }
+    }
+
+    THEN("the exception reaches the caller and the workers are released") {
+      REQUIRE(thrown);
+      REQUIRE(factory_calls == 3);
+    }
+  }
+}
@@ -0,0 +1,274 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/callable_overload.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/reload.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct InvalidPortError {
+    static constexpr auto description = "Port is invalid";
+  };
+
+  struct EmptyRouteError {
+    static constexpr auto description = "Route is empty";
+  };
+
+  int listener_factory_runs = 0;
+  int routes_factory_runs = 0;
+
+  class Listener final : public mp::Helpers<Listener> {
+  public:
+    int get_port() const { return port; }
+
+  private:
+    friend class mp::Helpers<Listener>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int port
+      ) {
+        ++listener_factory_runs;
+        if (port <= 0 || port > 65535) return on_fail(InvalidPortError{});
+        return on_success(mp::builder(constructor, port));
+      };
+    }
+
+    int port;
+
+  public:
+    Listener(typename mp::Helpers<Listener>::Private, int port_)
+      : port{port_}
+    {}
+
+#if __cplusplus >= 201703L
+    // Versions are constructed in the allocation that shares them
+    Listener(Listener const &) = delete;
+    Listener(Listener &&) = delete;
+#endif
+  };
+
+  class Routes final : public mp::Helpers<Routes> {
+  public:
+    std::string const &get_route() const { return route; }
+
+  private:
+    friend class mp::Helpers<Routes>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string route
+      ) {
+        ++routes_factory_runs;
+        if (route.empty()) return on_fail(EmptyRouteError{});
+        return on_success(mp::builder(constructor, std::move(route)));
+      };
+    }
+
+    std::string route;
+
+  public:
+    Routes(typename mp::Helpers<Routes>::Private, std::string route_)
+      : route{std::move(route_)}
+    {}
+  };
+
+  class Server final : public mp::Helpers<Server> {
+  public:
+    Listener const &get_listener() const { return *listener; }
+    Routes const &get_routes() const { return *routes; }
+    int get_generation() const { return generation; }
+
+    std::shared_ptr<Listener const> const &share_listener() const {
+      return listener;
+    }
+    std::shared_ptr<Routes const> const &share_routes() const {
+      return routes;
+    }
+
+  private:
+    friend class mp::Helpers<Server>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto listener, auto routes, int generation
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(listener), std::move(routes))
+        , mp::arguments(generation)
+        );
+      };
+    }
+
+    int generation;
+    std::shared_ptr<Listener const> listener;
+    std::shared_ptr<Routes const> routes;
+
+  public:
+    template <typename ListenerBuilder, typename RoutesBuilder>
+    Server(
+      typename mp::Helpers<Server>::Private
+    , int generation_
+    , ListenerBuilder listener_, RoutesBuilder routes_
+    ) : generation{generation_}
+      , listener{std::move(listener_).construct()}
+      , routes{std::move(routes_).construct()}
+    {}
+  };
+
+  struct Config {
+    mp::Reusable<Listener, int> listener;
+    mp::Reusable<Routes, std::string> routes;
+    mp::Live<Server> server;
+
+    bool push(int port, std::string const &route, int generation) {
+      return server.reload(
+        Server::builder(
+          listener.builder(port), routes.builder(route), generation
+        )
+      , [](auto) {}
+      );
+    }
+  };
+}
+
+SCENARIO("hot reload") {
+  listener_factory_runs = 0;
+  routes_factory_runs = 0;
+  Config config;
+
+  GIVEN("nothing has been loaded") {
+    THEN("there is no live version") {
+      REQUIRE(config.server.load() == nullptr);
+    }
+  }
+
+  GIVEN("a live version") {
+    REQUIRE(config.push(8080, "/a", 1));
+    auto first = config.server.load();
+    REQUIRE(first != nullptr);
+    REQUIRE(first->get_listener().get_port() == 8080);
+    REQUIRE(first->get_routes().get_route() == "/a");
+    REQUIRE(listener_factory_runs == 1);
+    REQUIRE(routes_factory_runs == 1);
+
+    WHEN("one member's arguments change") {
+      REQUIRE(config.push(8080, "/b", 2));
+      auto second = config.server.load();
+
+      THEN("only that member's factory runs again") {
+        REQUIRE(listener_factory_runs == 1);
+        REQUIRE(routes_factory_runs == 2);
+        REQUIRE(second->get_generation() == 2);
+        REQUIRE(second->get_routes().get_route() == "/b");
+      }
+
+      THEN("the unchanged member is shared with the previous version") {
+        REQUIRE(second->share_listener() == first->share_listener());
+        REQUIRE(second->share_routes() != first->share_routes());
+      }
+
+      THEN("readers of the previous version are unaffected") {
+        REQUIRE(first->get_generation() == 1);
+        REQUIRE(first->get_routes().get_route() == "/a");
+      }
+    }
+
+    WHEN("validation fails") {
+      std::vector<std::string> errors;
+      bool published = config.server.reload(
+        Server::builder(
+          config.listener.builder(-1), config.routes.builder("/c"), 2
+        )
+      , mp::handler(
+          [&](InvalidPortError e) { errors.push_back(e.description); }
+        , [&](EmptyRouteError e) { errors.push_back(e.description); }
+        )
+      );
+
+      THEN("the failure is reported and the live version is untouched") {
+        REQUIRE_FALSE(published);
+        REQUIRE(errors == std::vector<std::string>{"Port is invalid"});
+        REQUIRE(config.server.load() == first);
+      }
+
+      THEN("the members of the live version can still be reused") {
+        REQUIRE(config.push(8080, "/a", 3));
+        REQUIRE(listener_factory_runs == 2);
+        REQUIRE(routes_factory_runs == 1);
+        REQUIRE(config.server.load()->share_listener()
+          == first->share_listener());
+      }
+    }
+
+    WHEN("no reader refers to an old version any more") {
+      std::weak_ptr<Server const> old = first;
+      REQUIRE(config.push(9090, "/a", 2));
+      REQUIRE_FALSE(old.expired());
+      first.reset();
+
+      THEN("it is destroyed") {
+        REQUIRE(old.expired());
+      }
+    }
+  }
+
+  WHEN("readers load while versions are published") {
+    REQUIRE(config.push(1, "1", 1));
+    std::atomic<bool> done{false};
+    std::vector<int> consistent(4, 1);
+    std::vector<std::thread> readers;
+    for (std::size_t i = 0; i < consistent.size(); ++i) {
+      readers.emplace_back([&, i] {
+        while (!done.load()) {
+          auto server = config.server.load();
+          // Every version is built from arguments of one generation
+          int generation = server->get_generation();
+          if (
+            server->get_listener().get_port() != generation
+            || server->get_routes().get_route() != std::to_string(generation)
+          ) {
+            consistent[i] = 0;
+          }
+        }
+      });
+    }
+    bool all_published = true;
+    for (int generation = 2; generation <= 200; ++generation) {
+      all_published = config.push(
+        generation, std::to_string(generation), generation
+      ) && all_published;
+    }
+    done = true;
+    for (auto &reader : readers) reader.join();
+
+    THEN("every reader sees a whole version") {
+      REQUIRE(all_published);
+      REQUIRE(config.server.load()->get_generation() == 200);
+      REQUIRE(consistent == std::vector<int>(4, 1));
+    }
+  }
+}
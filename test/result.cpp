@@ -0,0 +1,279 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/result.hpp>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  struct EmptyHostError {
+    static constexpr auto description = "Host is empty";
+  };
+
+  struct PortRangeError {
+    static constexpr auto description = "Port is out of range";
+  };
+
+  struct UnnamedError {};
+
+  class Host final
+    : public mp::Helpers<Host>
+    , public mp::ResultHelper<mp::Helpers<Host>>
+  {
+  public:
+    std::string const &get_name() const { return name; }
+
+  private:
+    friend class mp::Helpers<Host>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name
+      ) {
+        if (name.empty()) return on_fail(EmptyHostError{});
+        return on_success(mp::builder(constructor, std::move(name)));
+      };
+    }
+
+    std::string name;
+
+  public:
+    Host(typename mp::Helpers<Host>::Private, std::string name_)
+      : name{std::move(name_)}
+    {}
+  };
+
+  class Port final
+    : public mp::Helpers<Port>
+    , public mp::ResultHelper<mp::Helpers<Port>>
+  {
+  public:
+    int get_number() const { return number; }
+
+  private:
+    friend class mp::Helpers<Port>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int number
+      ) {
+        if (number <= 0 || number > 65535) return on_fail(PortRangeError{});
+        return on_success(mp::builder(constructor, number));
+      };
+    }
+
+    int number;
+
+  public:
+    Port(typename mp::Helpers<Port>::Private, int number_)
+      : number{number_}
+    {}
+  };
+
+  class Endpoint final
+    : public mp::Helpers<Endpoint>
+    , public mp::ResultHelper<mp::Helpers<Endpoint>>
+  {
+  public:
+    std::string to_string() const {
+      return host.get_name() + ":" + std::to_string(port.get_number());
+    }
+
+  private:
+    friend class mp::Helpers<Endpoint>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto host, auto port
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(host), std::move(port))
+        );
+      };
+    }
+
+    Host host;
+    Port port;
+
+  public:
+    template <typename H, typename P>
+    Endpoint(typename mp::Helpers<Endpoint>::Private, H host_, P port_)
+      : host{std::move(host_).construct()}
+      , port{std::move(port_).construct()}
+    {}
+  };
+
+  int live = 0;
+  bool copies_throw = false;
+
+  struct CopyError {};
+
+  // Counts its live instances, and its copies throw on demand
+  struct Fragile {
+    explicit Fragile(int value_) : value{value_} { ++live; }
+    Fragile(Fragile const &other) : value{other.value} {
+      if (copies_throw) throw CopyError{};
+      ++live;
+    }
+    Fragile(Fragile &&other) noexcept : value{other.value} { ++live; }
+    ~Fragile() { --live; }
+
+    int value;
+  };
+
+  mp::Result<int> parse_port(std::string const &text) {
+    if (text.empty()) return mp::Result<int>{UnnamedError{}};
+    return std::stoi(text);
+  }
+}
+
+SCENARIO("compact results") {
+  WHEN("construction succeeds") {
+    auto port = Port::result(8080);
+
+    THEN("the result holds the value") {
+      REQUIRE(port.has_value());
+      REQUIRE(static_cast<bool>(port));
+      REQUIRE(port->get_number() == 8080);
+      REQUIRE(port.error_id() == 0);
+      REQUIRE(port.error_description() == nullptr);
+    }
+  }
+
+  WHEN("construction fails") {
+    auto port = Port::result(0);
+
+    THEN("the result holds the error's id") {
+      REQUIRE(!port.has_value());
+      REQUIRE(port.holds_error<PortRangeError>());
+      REQUIRE(!port.holds_error<EmptyHostError>());
+      REQUIRE(port.error_id() == mp::error_id<PortRangeError>());
+      REQUIRE(
+        port.error_description() == std::string{PortRangeError::description}
+      );
+    }
+  }
+
+  WHEN("a nested factory fails") {
+    auto good = Endpoint::result(Host::builder("localhost"), Port::builder(80));
+    auto bad = Endpoint::result(Host::builder(""), Port::builder(80));
+
+    THEN("its error is recorded without being listed anywhere") {
+      REQUIRE(good->to_string() == "localhost:80");
+      REQUIRE(bad.holds_error<EmptyHostError>());
+    }
+  }
+
+  WHEN("error types are used") {
+    auto host = mp::error_id<EmptyHostError>();
+    auto port = mp::error_id<PortRangeError>();
+    auto unnamed = mp::error_id<UnnamedError>();
+
+    THEN("they get small distinct ids") {
+      REQUIRE(host > 0);
+      REQUIRE(port > 0);
+      REQUIRE(host != port);
+      REQUIRE(unnamed != host);
+      REQUIRE(unnamed != port);
+      REQUIRE(
+        mp::error_description(host) == std::string{EmptyHostError::description}
+      );
+      REQUIRE(
+        mp::error_description(unnamed)
+        == std::string{mp::type_name<UnnamedError>()}
+      );
+    }
+  }
+
+  WHEN("results are composed") {
+    auto describe = [](Port port) {
+      return std::to_string(port.get_number());
+    };
+    auto const port = Port::result(443);
+    auto mapped = port.map(describe);
+    auto failed = Port::result(-1).map(describe);
+    auto chained = parse_port("22").and_then(
+      [](int number) { return Port::result(number); }
+    );
+    auto short_circuited = parse_port("").and_then(
+      [](int number) { return Port::result(number); }
+    );
+
+    THEN("errors pass through unchanged") {
+      REQUIRE(*mapped == "443");
+      REQUIRE(port->get_number() == 443);
+      REQUIRE(failed.holds_error<PortRangeError>());
+      REQUIRE(chained->get_number() == 22);
+      REQUIRE(short_circuited.holds_error<UnnamedError>());
+      REQUIRE(failed.value_or("none") == "none");
+      REQUIRE(mapped.value_or("none") == "443");
+    }
+  }
+
+  WHEN("results are copied and moved") {
+    std::vector<mp::Result<std::string>> results;
+    results.push_back(std::string{"a long enough string to allocate"});
+    results.emplace_back(EmptyHostError{});
+    auto copies = results;
+    auto moved = std::move(results);
+    copies[1] = moved[0];
+    moved[0] = mp::Result<std::string>{PortRangeError{}};
+
+    THEN("the value or error follows") {
+      REQUIRE(*copies[0] == "a long enough string to allocate");
+      REQUIRE(*copies[1] == "a long enough string to allocate");
+      REQUIRE(moved[0].holds_error<PortRangeError>());
+      REQUIRE(moved[1].holds_error<EmptyHostError>());
+    }
+  }
+
+  WHEN("copying the value throws during assignment") {
+    live = 0;
+    {
+      mp::Result<Fragile> target{Fragile{1}};
+      mp::Result<Fragile> const source{Fragile{2}};
+      copies_throw = true;
+      REQUIRE_THROWS_AS(target = source, CopyError);
+      copies_throw = false;
+
+      THEN("the target holds an error and nothing is destroyed twice") {
+        REQUIRE(!target);
+        REQUIRE(target.holds_error<mp::ValuelessError>());
+        REQUIRE(live == 1);
+      }
+    }
+    REQUIRE(live == 0);
+  }
+
+  THEN("errors don't convert to a result implicitly") {
+    REQUIRE(!std::is_convertible<PortRangeError, mp::Result<int>>::value);
+    REQUIRE(std::is_constructible<mp::Result<int>, PortRangeError>::value);
+  }
+
+  THEN("a result is no larger than its value and an id") {
+    REQUIRE(sizeof(mp::Result<int>) == 2 * sizeof(int));
+    REQUIRE(sizeof(mp::Result<Port>) == sizeof(mp::Result<int>));
+    REQUIRE(sizeof(mp::Result<std::uint16_t>) == 2 * sizeof(std::uint16_t));
+  }
+}
@@ -0,0 +1,210 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/shared.hpp>
+
+#if __cplusplus >= 201703L
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  std::atomic<int> pools_constructed{0};
+  std::atomic<int> factory_calls{0};
+
+  struct NoConnectionsError {
+    static constexpr auto description = "Pool needs at least one connection";
+  };
+
+  class Pool final : public mp::Helpers<Pool> {
+  public:
+    int get_size() const { return size; }
+
+    Pool(Pool const &) = delete;
+    Pool(Pool &&) = delete;
+
+  private:
+    friend class mp::Helpers<Pool>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int size
+      ) {
+        ++factory_calls;
+        if (size <= 0) return on_fail(NoConnectionsError{});
+        return on_success(mp::builder(constructor, size));
+      };
+    }
+
+    int size;
+
+  public:
+    Pool(typename mp::Helpers<Pool>::Private, int size_) : size{size_} {
+      // Slow enough that concurrent first uses overlap
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      ++pools_constructed;
+    }
+  };
+
+  // A user of the pool that also has dependencies of its own
+  class Service final : public mp::Helpers<Service> {
+  public:
+    Pool const &get_pool() const { return pool; }
+    std::string const &get_name() const { return name; }
+
+  private:
+    friend class mp::Helpers<Service>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , std::string name
+      , auto pool
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(pool))
+        , mp::arguments(std::move(name))
+        );
+      };
+    }
+
+    std::string name;
+    Pool &pool;
+
+  public:
+    // Braces would bind `pool` to a copy of the wrapped reference
+    template <typename P>
+    Service(typename mp::Helpers<Service>::Private, std::string name_, P pool_)
+      : name{std::move(name_)}, pool(std::move(pool_).construct())
+    {}
+  };
+
+  template <typename PoolBuilder>
+  std::string describe(PoolBuilder pool_builder, std::string name) {
+    auto service_builder = Service::builder(
+      std::move(name), std::move(pool_builder)
+    );
+    return std::move(service_builder).construct(
+      [](auto builder) {
+        auto service = std::move(builder).construct();
+        return service.get_name() + ":" + std::to_string(
+          service.get_pool().get_size()
+        );
+      }
+    , [](auto error) { return std::string{error.description}; }
+    );
+  }
+}
+
+SCENARIO("shared dependencies") {
+  pools_constructed = 0;
+  factory_calls = 0;
+
+  WHEN("several aggregates use the same shared dependency") {
+    mp::Shared<Pool, NoConnectionsError> pool;
+    Pool const *first = nullptr;
+    Pool const *second = nullptr;
+    Service::builder("a", pool.builder(Pool::builder(4))).construct(
+      [&](auto builder) {
+        first = &std::move(builder).construct().get_pool();
+      }
+    , [](auto) {}
+    );
+    Service::builder("b", pool.builder(Pool::builder(8))).construct(
+      [&](auto builder) {
+        second = &std::move(builder).construct().get_pool();
+      }
+    , [](auto) {}
+    );
+
+    THEN("it is constructed once and every aggregate refers to it") {
+      REQUIRE(pools_constructed == 1);
+      REQUIRE(factory_calls == 1);
+      REQUIRE(first == second);
+      REQUIRE(first->get_size() == 4);
+    }
+  }
+
+  WHEN("the shared factory fails") {
+    mp::Shared<Pool, NoConnectionsError> pool;
+    auto a = describe(pool.builder(Pool::builder(0)), "a");
+    auto b = describe(pool.builder(Pool::builder(4)), "b");
+
+    THEN("every user sees the error") {
+      REQUIRE(a == NoConnectionsError::description);
+      REQUIRE(b == NoConnectionsError::description);
+      REQUIRE(factory_calls == 1);
+    }
+  }
+
+  WHEN("many threads use it for the first time at once") {
+    mp::Shared<Pool, NoConnectionsError> pool;
+    std::vector<std::string> results(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      threads.emplace_back([&, i] {
+        results[i] = describe(pool.builder(Pool::builder(3)), "t");
+      });
+    }
+    for (auto &thread : threads) thread.join();
+
+    THEN("the factory still runs once") {
+      REQUIRE(factory_calls == 1);
+      REQUIRE(pools_constructed == 1);
+      for (auto const &result : results) REQUIRE(result == "t:3");
+    }
+  }
+
+  WHEN("the process-wide instance is used") {
+    using mp::shared;
+    auto a = describe(shared<Pool, NoConnectionsError>(Pool::builder(5)), "a");
+    auto b = describe(shared<Pool, NoConnectionsError>(Pool::builder(6)), "b");
+
+    THEN("all callers share it") {
+      REQUIRE(a == "a:5");
+      REQUIRE(b == "b:5");
+      REQUIRE(pools_constructed <= 1);
+    }
+  }
+
+  WHEN("the dependency can't fail") {
+    struct Registry {
+      int counters;
+    };
+    mp::Shared<Registry> registry;
+    auto get = [](auto builder) -> Registry * {
+      return &std::move(builder).construct().get();
+    };
+    auto fail = [](auto) -> Registry * { return nullptr; };
+    auto first = registry.builder(mp::wrapper<Registry>(1))
+      .construct(get, fail);
+    auto second = registry.builder(mp::wrapper<Registry>(2))
+      .construct(get, fail);
+
+    THEN("no error type is needed") {
+      REQUIRE(first == second);
+      REQUIRE(first->counters == 1);
+    }
+  }
+}
+
+#endif
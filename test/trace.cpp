@@ -0,0 +1,312 @@
+#if defined(_MSC_VER)
+  #pragma warning( push )
+  #pragma warning( disable : 4244 )
+#endif
+#include <catch.hpp>
+#if defined(_MSC_VER)
+  #pragma warning( pop )
+#endif
+#include <mz/piecewise/chrome_tracer.hpp>
+#include <mz/piecewise/factory.hpp>
+#include <mz/piecewise/helpers.hpp>
+#include <mz/piecewise/multifail.hpp>
+#include <mz/piecewise/trace.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mp = mz::piecewise;
+
+namespace {
+  // Records every event as "<event> <type> <depth>"
+  struct Recorder {
+    static std::vector<std::string> events;
+
+    template <typename T>
+    static std::string entry(char const *event, std::size_t depth) {
+      return std::string{event} + " " + mp::type_name<T>()
+        + " " + std::to_string(depth);
+    }
+
+    template <typename T>
+    static void factory_start(std::size_t depth) {
+      events.push_back(entry<T>("factory_start", depth));
+    }
+
+    template <typename T>
+    static void factory_success(std::size_t depth) {
+      events.push_back(entry<T>("factory_success", depth));
+    }
+
+    template <typename T, typename Error>
+    static void factory_failure(std::size_t depth, Error const &) {
+      events.push_back(
+        entry<T>("factory_failure", depth) + " " + mp::type_name<Error>()
+      );
+    }
+
+    template <typename T>
+    static void constructor_start(std::size_t depth) {
+      events.push_back(entry<T>("constructor_start", depth));
+    }
+
+    template <typename T>
+    static void constructor_end(std::size_t depth) {
+      events.push_back(entry<T>("constructor_end", depth));
+    }
+  };
+
+  std::vector<std::string> Recorder::events;
+
+  struct NegativeSizeError {
+    static constexpr auto description = "Size is negative";
+  };
+
+  class Wheel final : public mp::Helpers<Wheel, Recorder> {
+  public:
+    int get_size() const { return size; }
+
+  private:
+    friend class mp::Helpers<Wheel, Recorder>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int size
+      ) {
+        if (size < 0) return on_fail(NegativeSizeError{});
+        return on_success(mp::builder(constructor, size));
+      };
+    }
+
+    int size;
+
+  public:
+    Wheel(typename mp::Helpers<Wheel, Recorder>::Private, int size_)
+      : size{size_}
+    {}
+  };
+
+  class Cart final : public mp::Helpers<Cart, Recorder> {
+  public:
+    int get_size() const { return front.get_size() + back.get_size(); }
+
+  private:
+    friend class mp::Helpers<Cart, Recorder>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , auto front, auto back
+      ) {
+        return mp::multifail(
+          constructor
+        , on_success, on_fail
+        , mp::builders(std::move(front), std::move(back))
+        );
+      };
+    }
+
+    Wheel front;
+    Wheel back;
+
+  public:
+    template <typename F, typename B>
+    Cart(typename mp::Helpers<Cart, Recorder>::Private, F front_, B back_)
+      : front{std::move(front_).construct()}
+      , back{std::move(back_).construct()}
+    {}
+  };
+
+  struct Bolt {
+    int size;
+  };
+
+  struct Rack {
+    Bolt left;
+    Bolt right;
+  };
+
+  template <typename Builder>
+  int size_of(Builder builder) {
+    return std::move(builder).construct(
+      [](auto post) { return std::move(post).construct().get_size(); }
+    , [](auto) { return -1; }
+    );
+  }
+}
+
+SCENARIO("construction tracing") {
+  Recorder::events.clear();
+
+  WHEN("a traced aggregate is constructed") {
+    auto size = size_of(Cart::builder(Wheel::builder(1), Wheel::builder(2)));
+
+    THEN("every factory and constructor is reported with its depth") {
+      REQUIRE(size == 3);
+      std::vector<std::string> expected = {
+        Recorder::entry<Cart>("factory_start", 0)
+      , Recorder::entry<Wheel>("factory_start", 1)
+      , Recorder::entry<Wheel>("factory_success", 1)
+      , Recorder::entry<Wheel>("factory_start", 1)
+      , Recorder::entry<Wheel>("factory_success", 1)
+      , Recorder::entry<Cart>("factory_success", 0)
+      , Recorder::entry<Cart>("constructor_start", 0)
+      , Recorder::entry<Wheel>("constructor_start", 1)
+      , Recorder::entry<Wheel>("constructor_end", 1)
+      , Recorder::entry<Wheel>("constructor_start", 1)
+      , Recorder::entry<Wheel>("constructor_end", 1)
+      , Recorder::entry<Cart>("constructor_end", 0)
+      };
+      REQUIRE(Recorder::events == expected);
+    }
+  }
+
+  WHEN("a nested factory fails") {
+    auto size = size_of(Cart::builder(Wheel::builder(1), Wheel::builder(-1)));
+
+    THEN("the failure is reported with its error type at every level") {
+      REQUIRE(size == -1);
+      auto error = std::string{" "} + mp::type_name<NegativeSizeError>();
+      std::vector<std::string> expected = {
+        Recorder::entry<Cart>("factory_start", 0)
+      , Recorder::entry<Wheel>("factory_start", 1)
+      , Recorder::entry<Wheel>("factory_success", 1)
+      , Recorder::entry<Wheel>("factory_start", 1)
+      , Recorder::entry<Wheel>("factory_failure", 1) + error
+      , Recorder::entry<Cart>("factory_failure", 0) + error
+      };
+      REQUIRE(Recorder::events == expected);
+    }
+  }
+
+  WHEN("multifail is given traced builders") {
+    auto rack = mp::multifail(
+      [](auto left, auto right) {
+        return Rack{std::move(left).construct(), std::move(right).construct()};
+      }
+    , [](auto builder) { return std::move(builder).construct(); }
+    , [](auto) { return Rack{{0}, {0}}; }
+    , mp::traced_builders<Recorder>(
+        mp::builder(mp::factory<Bolt>, 4), mp::builder(mp::factory<Bolt>, 5)
+      )
+    );
+
+    THEN("they are reported under the type they construct") {
+      REQUIRE(rack.left.size == 4);
+      REQUIRE(rack.right.size == 5);
+      std::vector<std::string> expected = {
+        Recorder::entry<Bolt>("factory_start", 0)
+      , Recorder::entry<Bolt>("factory_success", 0)
+      , Recorder::entry<Bolt>("factory_start", 0)
+      , Recorder::entry<Bolt>("factory_success", 0)
+      , Recorder::entry<Bolt>("constructor_start", 0)
+      , Recorder::entry<Bolt>("constructor_end", 0)
+      , Recorder::entry<Bolt>("constructor_start", 0)
+      , Recorder::entry<Bolt>("constructor_end", 0)
+      };
+      REQUIRE(Recorder::events == expected);
+    }
+  }
+
+#if __cplusplus >= 201703L
+  WHEN("a traced type is constructed as a variant or an optional") {
+    auto variant = Wheel::variant<NegativeSizeError>(6);
+    auto optional = Wheel::optional(-1).construct([](auto) {});
+
+    THEN("they are reported like builders") {
+      REQUIRE(std::get<Wheel>(variant).get_size() == 6);
+      REQUIRE(!optional);
+      auto error = std::string{" "} + mp::type_name<NegativeSizeError>();
+      std::vector<std::string> expected = {
+        Recorder::entry<Wheel>("factory_start", 0)
+      , Recorder::entry<Wheel>("factory_success", 0)
+      , Recorder::entry<Wheel>("constructor_start", 0)
+      , Recorder::entry<Wheel>("constructor_end", 0)
+      , Recorder::entry<Wheel>("factory_start", 0)
+      , Recorder::entry<Wheel>("factory_failure", 0) + error
+      };
+      REQUIRE(Recorder::events == expected);
+    }
+  }
+#endif
+}
+
+namespace {
+  class Lamp final : public mp::Helpers<Lamp, mp::ChromeTracer> {
+  public:
+    int get_watts() const { return watts; }
+
+  private:
+    friend class mp::Helpers<Lamp, mp::ChromeTracer>;
+
+    static auto factory() {
+      return [](
+        auto constructor
+      , auto&& on_success, auto&& on_fail
+      , int watts
+      ) {
+        if (watts < 0) return on_fail(NegativeSizeError{});
+        return on_success(mp::builder(constructor, watts));
+      };
+    }
+
+    int watts;
+
+  public:
+    Lamp(typename mp::Helpers<Lamp, mp::ChromeTracer>::Private, int watts_)
+      : watts{watts_}
+    {}
+  };
+}
+
+SCENARIO("chrome trace export") {
+  mp::ChromeTracer::clear();
+
+  WHEN("traced objects are constructed") {
+    auto watts = Lamp::builder(60).construct(
+      [](auto post) { return std::move(post).construct().get_watts(); }
+    , [](auto) { return -1; }
+    );
+    auto failed = Lamp::builder(-1).construct(
+      [](auto) { return true; }
+    , [](auto) { return false; }
+    );
+    std::ostringstream out;
+    mp::ChromeTracer::write(out);
+    auto json = out.str();
+
+    THEN("a complete event is recorded for each") {
+      REQUIRE(watts == 60);
+      REQUIRE(!failed);
+      REQUIRE(mp::ChromeTracer::size() == 3);
+      REQUIRE(json.find("{\"traceEvents\":[") == 0);
+      REQUIRE(json.find("\"cat\":\"factory\"") != std::string::npos);
+      REQUIRE(json.find("\"cat\":\"constructor\"") != std::string::npos);
+      REQUIRE(json.find("\"ph\":\"X\"") != std::string::npos);
+      REQUIRE(json.find(mp::type_name<Lamp>()) != std::string::npos);
+      REQUIRE(
+        json.find(mp::type_name<NegativeSizeError>()) != std::string::npos
+      );
+    }
+
+    THEN("it can be written to a file") {
+      auto path = std::string{"piecewise_trace_test.json"};
+      REQUIRE(mp::ChromeTracer::write(path));
+      std::ifstream in{path};
+      std::string contents{
+        std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}
+      };
+      in.close();
+      std::remove(path.c_str());
+      REQUIRE(contents == json);
+    }
+  }
+}